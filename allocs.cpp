@@ -0,0 +1,100 @@
+/*
+ *      allocs.cpp
+ *
+ *      Purpose: Counts every heap allocation made through operator new, by
+ *               any thread, when built with -DPOKESIM_COUNT_ALLOCS. The
+ *               replacement operators are linked into any program that
+ *               reads the count.
+ *
+ *      Last modified: October 19, 2026
+ */
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "allocs.h"
+
+using namespace std;
+
+#ifdef POKESIM_COUNT_ALLOCS
+
+atomic<unsigned long> allocations(0);
+
+void *countedAlloc(size_t size);
+
+/*
+ *  countedAlloc()
+ *
+ *  Parameters: bytes to allocate
+ *  Does:       Counts the allocation and takes the bytes from malloc.
+ *  Returns:    Pointer to the bytes, or NULL if malloc failed
+ */
+void *countedAlloc(size_t size)
+{
+    allocations.fetch_add(1, memory_order_relaxed);
+
+    return malloc(size == 0 ? 1 : size);
+}
+
+void *operator new(size_t size)
+{
+    void *memory = countedAlloc(size);
+    if (memory == NULL)
+        throw bad_alloc();
+
+    return memory;
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void *operator new(size_t size, const nothrow_t &) noexcept
+{
+    return countedAlloc(size);
+}
+
+void *operator new[](size_t size, const nothrow_t &) noexcept
+{
+    return countedAlloc(size);
+}
+
+void operator delete(void *memory) noexcept
+{
+    free(memory);
+}
+
+void operator delete[](void *memory) noexcept
+{
+    free(memory);
+}
+
+void operator delete(void *memory, const nothrow_t &) noexcept
+{
+    free(memory);
+}
+
+void operator delete[](void *memory, const nothrow_t &) noexcept
+{
+    free(memory);
+}
+
+#endif
+
+/*
+ *  allocationCount()
+ *
+ *  Parameters: NA
+ *  Does:       Reads how many heap allocations the program has made.
+ *  Returns:    Allocations so far, or 0 if counting is not compiled in
+ */
+unsigned long allocationCount()
+{
+#ifdef POKESIM_COUNT_ALLOCS
+    return allocations.load(memory_order_relaxed);
+#else
+    return 0;
+#endif
+}
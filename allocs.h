@@ -0,0 +1,23 @@
+/*
+ *      allocs.h
+ *
+ *      Purpose: Heap allocation counting for checking that hot loops stay
+ *               off the heap. Counting is compiled in only when building
+ *               with -DPOKESIM_COUNT_ALLOCS, which replaces the global
+ *               operator new; otherwise no allocation is counted.
+ *
+ *      Last modified: October 19, 2026
+ */
+
+#ifndef ALLOCS_H
+#define ALLOCS_H
+
+#ifdef POKESIM_COUNT_ALLOCS
+const bool COUNTING_ALLOCS = true;
+#else
+const bool COUNTING_ALLOCS = false;
+#endif
+
+unsigned long allocationCount();
+
+#endif
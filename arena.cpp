@@ -0,0 +1,139 @@
+/*
+ *      arena.cpp
+ *
+ *      Purpose: Bump allocation from a chain of retained blocks, and the
+ *               per-thread arena the matchup solvers take their tables
+ *               from.
+ *
+ *      Last modified: October 19, 2026
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+#include "arena.h"
+
+using namespace std;
+
+const size_t ARENA_ALIGN = 16;
+
+/*
+ * ThreadArena
+ *
+ * Owns one thread's arena, freeing its blocks when the thread exits.
+ */
+struct ThreadArena {
+    Arena arena;
+
+    ThreadArena() { initArena(arena); }
+    ~ThreadArena() { freeArena(arena); }
+};
+
+/*
+ *  initArena()
+ *
+ *  Parameters: arena
+ *  Does:       Empties the arena. It allocates its first block on first
+ *              use.
+ *  Returns:    NA
+ */
+void initArena(Arena &arena)
+{
+    arena.blocks.clear();
+    arena.current = 0;
+    arena.used = 0;
+}
+
+/*
+ *  freeArena()
+ *
+ *  Parameters: arena
+ *  Does:       Frees every block of the arena and empties it.
+ *  Returns:    NA
+ */
+void freeArena(Arena &arena)
+{
+    for (unsigned long i = 0; i < arena.blocks.size(); i++)
+        free(arena.blocks[i].data);
+
+    initArena(arena);
+}
+
+/*
+ *  arenaAlloc()
+ *
+ *  Parameters: arena, bytes to allocate
+ *  Does:       Takes the bytes (rounded up to ARENA_ALIGN) from the current
+ *              block, or the next kept block they fit in. Only if none is
+ *              left is a new block, of at least ARENA_BLOCK bytes, taken
+ *              from the heap.
+ *  Returns:    Pointer to the allocated bytes
+ */
+void *arenaAlloc(Arena &arena, size_t bytes)
+{
+    bytes = (bytes + ARENA_ALIGN - 1) / ARENA_ALIGN * ARENA_ALIGN;
+
+    while (arena.current < arena.blocks.size()) {
+        const ArenaBlock &block = arena.blocks[arena.current];
+
+        if (arena.used + bytes <= block.size) {
+            void *memory = block.data + arena.used;
+            arena.used += bytes;
+            return memory;
+        }
+        arena.current++;
+        arena.used = 0;
+    }
+
+    ArenaBlock block;
+    block.size = max(ARENA_BLOCK, bytes);
+    block.data = static_cast<char *>(malloc(block.size));
+    if (block.data == NULL)
+        throw bad_alloc();
+
+    arena.blocks.push_back(block);
+    arena.current = arena.blocks.size() - 1;
+    arena.used = bytes;
+
+    return block.data;
+}
+
+/*
+ *  arenaMark(), arenaRelease()
+ *
+ *  Parameters: arena / arena, mark to rewind to
+ *  Does:       Records the arena's position, or rewinds to a recorded one,
+ *              releasing (but keeping) everything allocated since.
+ *  Returns:    The mark / NA
+ */
+ArenaMark arenaMark(const Arena &arena)
+{
+    ArenaMark mark;
+
+    mark.block = arena.current;
+    mark.used = arena.used;
+
+    return mark;
+}
+
+void arenaRelease(Arena &arena, const ArenaMark &mark)
+{
+    arena.current = mark.block;
+    arena.used = mark.used;
+}
+
+/*
+ *  threadArena()
+ *
+ *  Parameters: NA
+ *  Does:       Finds the calling thread's arena, for scratch tables that
+ *              are released before the function using them returns.
+ *  Returns:    The thread's arena
+ */
+Arena &threadArena()
+{
+    static thread_local ThreadArena owner;
+
+    return owner.arena;
+}
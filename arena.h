@@ -0,0 +1,91 @@
+/*
+ *      arena.h
+ *
+ *      Purpose: Bump allocator for a simulation's scratch tables. Memory is
+ *               handed out from a chain of blocks and given back all at
+ *               once by rewinding to a mark; the blocks are kept for the
+ *               next simulation, so once an arena has grown to fit its
+ *               largest simulation, reusing it never touches the heap.
+ *
+ *      Last modified: October 19, 2026
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+const size_t ARENA_BLOCK = 64 * 1024;
+
+/*
+ * ArenaBlock, Arena
+ *
+ * An arena's blocks in the order they are filled, the block currently
+ * being filled, and the bytes used in it.
+ */
+struct ArenaBlock {
+    char *data;
+    size_t size;
+};
+
+struct Arena {
+    std::vector<ArenaBlock> blocks;
+    size_t current;
+    size_t used;
+};
+
+/*
+ * ArenaMark
+ *
+ * A position in an arena to rewind to, releasing everything allocated
+ * after it.
+ */
+struct ArenaMark {
+    size_t block;
+    size_t used;
+};
+
+void initArena(Arena &arena);
+void freeArena(Arena &arena);
+void *arenaAlloc(Arena &arena, size_t bytes);
+ArenaMark arenaMark(const Arena &arena);
+void arenaRelease(Arena &arena, const ArenaMark &mark);
+Arena &threadArena();
+
+/*
+ *  arenaArray()
+ *
+ *  Parameters: arena, number of elements
+ *  Does:       Allocates an uninitialized array of plain data from the
+ *              arena.
+ *  Returns:    Pointer to the first element
+ */
+template <typename T>
+T *arenaArray(Arena &arena, size_t count)
+{
+    return static_cast<T *>(arenaAlloc(arena, count * sizeof(T)));
+}
+
+/*
+ *  arenaGrow()
+ *
+ *  Parameters: arena, array of plain data allocated from it, elements in
+ *              use, new number of elements
+ *  Does:       Allocates a larger array from the arena and copies the
+ *              elements in use into it. The old array is released with the
+ *              rest of the arena.
+ *  Returns:    Pointer to the first element of the new array
+ */
+template <typename T>
+T *arenaGrow(Arena &arena, const T *array, size_t used, size_t count)
+{
+    T *grown = arenaArray<T>(arena, count);
+
+    std::memcpy(grown, array, used * sizeof(T));
+
+    return grown;
+}
+
+#endif
@@ -2,292 +2,189 @@
  * battle.cpp
  * 
  * Elizabeth Hom
- * Last Modified: May 15, 2020
+ * Last Modified: October 19, 2026
  * 
  * Purpose: Simulation of a Pokémon battle. Modeled on official franchise's
  *          compuational methods, invokes automated turn-based combat and
  *          accounts for type-advantages. Reports winning Pokémon and leftover
- *          HP.
+ *          HP. Battles are run by libpokesim; this file only prompts for the
+ *          battling Pokémon and narrates each turn. With --estimate, instead
+ *          estimates the 1st Pokémon's odds of winning to a given precision.
  */
 
 #include <iostream>
 #include <vector>
-#include <cstdlib>
 #include <string>
+#include <cstdlib>
+#include <cmath>
+#include <time.h>
 
-using namespace std;
-
-void populateChart(vector< vector<double> > &typeChart);
-void populateStats();
-double determineEffect(bool first, vector< vector<double> > &typeChart);
-void calcDamage(bool first, double effect);
-void battle(vector< vector<double> > &typeChart);
-bool calcMiss();
-bool calcCrit();
+#include "pokesim.h"
 
-/*
- * Pokémon
- *
- * Describes a single Pokémon: its name, type, stats (speed, attack, defense,
- * HP). Invokes two instances for the battling Pokemon.
- */
-struct pokemon {
-    string name;
-    int speed;
-    int attack;
-    int defense;
-    string type;
-    double HP;
-} mon1, mon2;
-
-int main()
-{
-    srand((unsigned)time(0));
-    vector<vector<double> >typeChart;
-    
-    // Populates Pokémon type chart
-    populateChart(typeChart);
-    // Populates battling Pokémons' stats
-    populateStats();
+using namespace std;
 
-    // Drives battle
-    battle(typeChart);
+const double DEFAULT_PRECISION = 0.005;
+const double DEFAULT_CONFIDENCE = 0.99;
 
-    return 0;
-}
+void populateStats(Pokemon &mon1, Pokemon &mon2);
+void reportBattle(const Pokemon &mon1, const Pokemon &mon2,
+                  const vector<TurnEvent> &log, const BattleResult &result);
+void reportEstimate(const Pokemon &mon1, const Pokemon &mon2,
+                    const MatchupResult &odds, double confidence);
 
-/*
- *  battle()
- *
- *  Parameters: typeChart vector
- *  Does:       Drives automated battle. Reports which Pokémon is attacking
- *              per turn and winner.
- *  Returns:    NA
- */
-void battle(vector< vector<double> > &typeChart)
+int main(int argc, char* argv[])
 {
-    int turns = 1;
-    bool first = false;
-
-    if (mon1.speed > mon2.speed) {
-        first = true;
+    SimContext ctx;
+    Pokemon mon1, mon2;
+    vector<TurnEvent> log;
+    bool estimate = (argc >= 2 and string(argv[1]) == "--estimate");
+
+    if (argc > 4 or (argc >= 2 and not estimate)) {
+        cout << "Usage: ./battle [--estimate [precision] [confidence]]"
+             << endl;
+        return 1;
     }
-    cout << endl;
 
-    do {
-        cout << "------------ TURN " << turns << " ------------" << endl;
+    double precision = (argc >= 3) ? atof(argv[2]) : DEFAULT_PRECISION;
+    double confidence = (argc >= 4) ? atof(argv[3]) : DEFAULT_CONFIDENCE;
 
-        if (first == true) {
-            cout << "*** " << mon1.name << " is attacking. ***" << endl;
-        } else {
-            cout << "*** " << mon2.name << " is attacking. ***" << endl;
-        }
-
-        double effect = determineEffect(first, typeChart);
-        calcDamage(first, effect);
-        turns++;
+    if (precision <= 0 or precision >= 1) {
+        cerr << "Precision must be between 0 and 1 (e.g. 0.005)." << endl;
+        return 1;
+    }
+    if (confidence <= 0 or confidence >= 1) {
+        cerr << "Confidence must be between 0 and 1 (e.g. 0.99)." << endl;
+        return 1;
+    }
 
-        if (first == true)
-            first = false;
-        else
-            first = true;
+    // Populates Pokémon type chart
+    initContext(ctx, (unsigned)time(0));
+    // Populates battling Pokémons' stats
+    populateStats(mon1, mon2);
 
-        cout << endl;
-    } while (mon1.HP > 0 and mon2.HP > 0);
+    if (estimate == true) {
+        MatchupResult odds = simulateMatchup(mon1, mon2, ctx.typeChart,
+                                             precision, confidence, ctx.rng);
+        reportEstimate(mon1, mon2, odds, confidence);
+        return 0;
+    }
 
-    if (mon1.HP <= 0)
-        cout << mon2.name << " won!" << endl;
-    else
-        cout << mon1.name << " won!" << endl;
-}
+    // Drives battle, into a log reserved up front as bench checks it
+    log.reserve(LOG_TURNS);
+    BattleResult result = battle(ctx, mon1, mon2, &log);
+    reportBattle(mon1, mon2, log, result);
 
-/*
- *  populateChart()
- *
- *  Parameters: typeChart vector
- *  Does:       Populates typeChart vector according to official Pokémon
- *              type advantages (https://pokemondb.net/type).
- *  Returns:    NA
- */
-void populateChart(vector< vector<double> > &typeChart)
-{
-    typeChart = { {1, 1, 1, 1, 1,.5, 1, 0,.5, 1, 1, 1, 1, 1, 1, 1, 1, 1},
-                  {2, 1, .5,.5,1, 2,.5, 0, 2, 1, 1, 1, 1,.5, 2, 1, 2,.5},
-                  {1, 2, 1, 1, 1,.5, 2, 1,.5, 1, 1, 2,.5, 1, 1, 1, 1, 1},
-                  {1, 1, 1,.5,.5,.5, 1,.5, 0, 1, 1, 2, 1, 1, 1, 1, 1, 2},
-                  {1, 1, 0, 2, 1, 2,.5, 1, 2, 2, 1,.5, 2, 1, 1, 1, 1, 1},
-                  {1,.5, 2, 1,.5, 1, 2, 1,.5, 2, 1, 1, 1, 1, 2, 1, 1, 1},
-                  {1,.5,.5,.5, 1, 1, 1,.5,.5,.5, 1, 2, 1, 2, 1, 1, 2,.5},
-                  {0, 1, 1, 1, 1, 1, 1, 2, 1, 1, 1, 1, 1, 2, 1, 1,.5, 1},
-                  {1, 1, 1,1 ,1 , 2, 1, 1,.5,.5,.5, 1,.5, 1, 2, 1, 1, 2},
-                  {1, 1, 1, 1, 1,.5, 2, 1, 2,.5,.5, 2, 1, 1, 2,.5, 1, 1},
-                  {1, 1, 1, 1, 2, 2, 1, 1, 1, 2,.5,.5, 1, 1, 1,.5, 1, 1},
-                  {1, 1,.5,.5, 2, 2,.5, 1,.5,.5, 2,.5, 1, 1, 1,.5, 1, 1},
-                  {1, 1, 2, 1, 0, 1, 1, 1, 1, 1, 2,.5,.5, 1, 1,.5, 1, 1},
-                  {1, 2, 1, 2, 1, 1, 1, 1,.5, 1, 1, 1, 1,.5, 1, 1, 0, 1},
-                  {1, 1, 2, 1, 2, 1, 1, 1,.5,.5,.5, 2, 1, 1,.5, 2, 1, 1},
-                  {1, 1, 1, 1, 1, 1, 1, 1,.5, 1, 1, 1, 1, 1, 1, 2, 1, 0},
-                  {1,.5, 1, 1, 1, 1, 1, 2, 1, 1, 1, 1, 1, 2, 1, 1,.5,.5},
-                  {1, 2, 1,.5 ,1, 1, 1, 1,.5,.5, 1, 1, 1, 1, 1, 2, 2, 1} };
+    return 0;
 }
 
 /*
  *  populateStats()
  *
- *  Parameters: NA
+ *  Parameters: the two battling Pokémon
  *  Does:       Prompts user for stats of battling Pokémon and populates
- *              mon1 and mon2 struct.
+ *              mon1 and mon2 struct. Attack, defense and speed are whole
+ *              numbers; HP is rounded to the nearest 1/STAT_SCALE.
  *  Returns:    NA
  */
-void populateStats()
+void populateStats(Pokemon &mon1, Pokemon &mon2)
 {
+    double HP = 0;
+    int attack = 0, defense = 0, speed = 0;
+
     cout << "Enter 1st pokemon's name, HP, attack, defense, speed, & type."
          << endl;
 
-    cin >> mon1.name >> mon1.HP >> mon1.attack >> mon1.defense >> mon1.speed
-        >> mon1.type;
+    cin >> mon1.name >> HP >> attack >> defense >> speed >> mon1.type;
+    mon1.HP = toFixed(HP, STAT_SCALE);
+    mon1.attack = attack * STAT_SCALE;
+    mon1.defense = defense * STAT_SCALE;
+    mon1.speed = speed * STAT_SCALE;
+    mon1.nextEvol = 0;
 
     cout << "Enter 2nd pokemon's name, HP, attack, defense, speed, & type."
          << endl;
 
-    cin >> mon2.name >> mon2.HP >> mon2.attack >> mon2.defense >> mon2.speed
-        >> mon2.type;
-}
-
-/*
- *  determineEffect()
- *
- *  Parameters: true if Pokémon was first to attack, typeChart vector
- *  Does:       Determines the numerical "effect" of the attacking Pokémon's
- *              attack based on the type advantage, using the typeChart. If
- *              attack is SUPER EFFECTIVE, NEUTRAL, NOT VERY EFFECTIVE, or
- *              NO EFFECT, attack power is multiplied by 2.0, 1.0, 0.5, and 0,
- *              respectively.
- *  Returns:    Attack effect (2.0, 1.0, 0.5, or 0)
- */
-double determineEffect(bool first, vector< vector<double> > &typeChart)
-{
-    string type1, type2;
-    if (first == true) {
-        type1 = mon1.type;
-        type2 = mon2.type;  
-    } else {
-        type1 = mon2.type;
-        type2 = mon1.type;
-    }
-
-    vector<string> type = {"normal", "fighting", "flying", "poison", "ground",
-                           "rock", "bug", "ghost", "steel", "fire", "water",
-                           "grass", "electric", "psychic", "ice", "dragon",
-                           "dark", "fairy"};
-
-    int index1 = 0;
-    int index2 = 0;
-
-    for (int i = 0; i < 18; i++) {
-        if (type1 == type[i])
-            index1 = i;
-        if (type2 == type[i])
-            index2 = i;
-    }
-
-    double effect = typeChart[index1][index2];
-
-    // Notifies user of attack effect
-    if (effect == 2.0)
-        cout << "\nIT'S SUPER EFFECTIVE!" << endl;
-    else if (effect == 0.5)
-        cout << "\nIT'S NOT VERY EFFECTIVE..." << endl;
-
-    type.clear();
-
-    return effect;
+    cin >> mon2.name >> HP >> attack >> defense >> speed >> mon2.type;
+    mon2.HP = toFixed(HP, STAT_SCALE);
+    mon2.attack = attack * STAT_SCALE;
+    mon2.defense = defense * STAT_SCALE;
+    mon2.speed = speed * STAT_SCALE;
+    mon2.nextEvol = 0;
 }
 
 /*
- *  calcDamage()
+ *  reportBattle()
  *
- *  Parameters: true if Pokémon was first to attack, attack effect (double)
- *  Does:       Calculates and deducts damage from defensive Pokémon's HP
- *              using mathematical methods of original Pokémon franchise.
+ *  Parameters: the two battling Pokémon, log of battle's turns, outcome
+ *  Does:       Reports which Pokémon is attacking per turn, the attack's
+ *              effect, damage, and both Pokémon's HP, then the winner.
  *  Returns:    NA
  */
-void calcDamage(bool first, double effect)
+void reportBattle(const Pokemon &mon1, const Pokemon &mon2,
+                  const vector<TurnEvent> &log, const BattleResult &result)
 {
-    if (calcMiss()) {
-        return;
-    }
+    cout << endl;
 
-    double damage = 0.0;
+    for (unsigned long i = 0; i < log.size(); i++) {
+        const TurnEvent &event = log[i];
 
-    // Multiples attack power by effect factor
-    if (first == true) {
-        if (mon1.attack <= mon2.defense)
-            damage = (1) * effect;
-        else
-            damage = (mon1.attack - mon2.defense) * effect; 
-    } else {
-        if (mon2.attack <= mon1.defense)
-            damage = (1) * effect;
-        else
-            damage = (mon2.attack - mon1.defense) * effect;
-    }
+        cout << "------------ TURN " << event.turn << " ------------" << endl;
+
+        if (event.firstAttacking == true) {
+            cout << "*** " << mon1.name << " is attacking. ***" << endl;
+        } else {
+            cout << "*** " << mon2.name << " is attacking. ***" << endl;
+        }
 
-    cout << "DAMAGE: " << damage << endl;
+        // Notifies user of attack effect
+        if (event.effect == 2 * EFFECT_SCALE)
+            cout << "\nIT'S SUPER EFFECTIVE!" << endl;
+        else if (event.effect == EFFECT_SCALE / 2)
+            cout << "\nIT'S NOT VERY EFFECTIVE..." << endl;
 
-    // Determines if attack is critical hit. If so, attack power is doubled
-    if (calcCrit()) {
-        if (first == true)
-            mon2.HP -= (damage * 2);
-        else
-            mon1.HP -= (damage * 2);
-    } else {
-        if (first == true)
-            mon2.HP -= damage;
-        else
-            mon1.HP -= damage;
-    }
+        if (event.missed == true) {
+            cout << "THE ATTACK MISSED!" << endl;
+        } else {
+            cout << "DAMAGE: " << fromFixed(event.damage, DAMAGE_SCALE)
+                 << endl;
 
-    cout << mon1.name << " HP: " << mon1.HP << endl;
-    cout << mon2.name << " HP: " << mon2.HP << endl;
-}
+            if (event.crit == true)
+                cout << "A CRITICAL HIT!" << endl;
 
-/*
- *  calcMiss()
- *
- *  Parameters: NA
- *  Does:       Determines whether attack missed using random number
- *              generator.
- *  Returns:    True if attack missed, otherwise false
- */
-bool calcMiss()
-{
-    int missIndex = (rand() % 20) + 1;
+            cout << mon1.name << " HP: " << fromFixed(event.HP1, DAMAGE_SCALE)
+                 << endl;
+            cout << mon2.name << " HP: " << fromFixed(event.HP2, DAMAGE_SCALE)
+                 << endl;
+        }
 
-    if (missIndex == 1) {
-        cout << "THE ATTACK MISSED!" << endl;
-        return true;
+        cout << endl;
     }
 
-    return false;
+    if (result.turns == 0)
+        cout << "Neither Pokémon can damage the other." << endl;
+    else if (result.firstWon == true)
+        cout << mon1.name << " won!" << endl;
+    else
+        cout << mon2.name << " won!" << endl;
 }
 
 /*
- *  calcCrit()
+ *  reportEstimate()
  *
- *  Parameters: NA
- *  Does:       Determines whether attack is critical hit using random number
- *              generator.
- *  Returns:    True if attack is critical, otherwise false
+ *  Parameters: the two battling Pokémon, estimated matchup, confidence level
+ *              it was estimated at
+ *  Does:       Reports the 1st Pokémon's odds of winning with their
+ *              confidence interval, the battles sampled, and the expected
+ *              length of battle.
+ *  Returns:    NA
  */
-bool calcCrit()
+void reportEstimate(const Pokemon &mon1, const Pokemon &mon2,
+                    const MatchupResult &odds, double confidence)
 {
-    int critIndex = (rand() % 20) + 1;
-
-    if (critIndex == 20) {
-        cout << "A CRITICAL HIT!" << endl;
-        return true;
-    }
-
-    return false;
+    cout << endl << mon1.name << " beats " << mon2.name << " "
+         << round(odds.winProb * 10000) / 100 << "% ± "
+         << round(odds.halfWidth * 10000) / 100 << "% of the time ("
+         << confidence * 100 << "% confidence, " << odds.samples
+         << " battles)" << endl;
+    cout << "Expected turns: " << odds.expTurns << endl;
 }
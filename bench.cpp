@@ -0,0 +1,532 @@
+/*
+ *      bench.cpp
+ *
+ *      Purpose: Measures memory use and scan throughput of the regular
+ *               Pokédex (vector of Pokemon structs) against the compact one
+ *               (16-byte records and structure-of-arrays columns). Runs a
+ *               stat table over every species at every level, a
+ *               round-robin tournament between every pair of species, and
+ *               Pokédex queries over the columns scaled to a million rows
+ *               (or a given row count).
+ *               Checks that estimated odds agree with the exact ones on
+ *               long matchups, and exits with an error if they do not.
+ *               Built with -DPOKESIM_COUNT_ALLOCS, also counts the heap
+ *               allocations of each simulation loop once warmed up, and
+ *               exits with an error if any loop allocated.
+ *
+ *      Last modified: October 19, 2026
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+
+#include "pokesim.h"
+#include "dexquery.h"
+#include "allocs.h"
+
+using namespace std;
+
+const int MAX_LEVEL = 100;
+const int TOURNAMENT_LEVEL = 50;
+const unsigned long QUERY_ROWS = 1 << 20;
+const double ESTIMATE_PRECISION = 0.01;
+const double ESTIMATE_CONFIDENCE = 0.95;
+const double CHECK_PRECISION = 0.01;
+const double CHECK_CONFIDENCE = 0.99;
+const unsigned CHECK_SEED = 20201019;
+/* The allocation check solves every attacker against every
+ * EXACT_STRIDE-th defender, a sample that keeps it to a few seconds even
+ * in an unoptimized build. */
+const unsigned long EXACT_STRIDE = 16;
+
+/*
+ * LongMatchup
+ *
+ * An even matchup whose battles run well past a thousand turns, since
+ * each side's resisted hits do at most one damage.
+ */
+struct LongMatchup {
+    const char *attacker;
+    int atkLevel;
+    const char *defender;
+    int defLevel;
+};
+
+const LongMatchup LONG_MATCHUPS[] = {{"quagsire", 77, "quagsire", 77},
+                                     {"bellossom", 98, "meganium", 96},
+                                     {"primarina", 76, "prinplup", 81}};
+const int LONG_MATCHUP_COUNT = 3;
+
+double elapsed(chrono::steady_clock::time_point start);
+void benchMemory(const SimContext &ctx);
+void benchStatTable(const SimContext &ctx, int reps);
+void benchTournament(const SimContext &ctx, int reps);
+void benchQuery(const SimContext &ctx, int reps, unsigned long queryRows);
+bool benchEstimates(const SimContext &ctx);
+bool benchAllocations(SimContext &ctx, int reps);
+bool reportAllocations(const char *phase, unsigned long before,
+                       unsigned long expected);
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2 or argc > 4) {
+        cout << "Usage: ./bench [pokedex] [repetitions] [query rows]"
+             << endl;
+        return 1;
+    }
+
+    SimContext ctx;
+    string error;
+    int reps = (argc >= 3) ? atoi(argv[2]) : 20;
+    long queryRows = (argc == 4) ? atol(argv[3]) : QUERY_ROWS;
+
+    if (reps < 1 or queryRows < 1) {
+        cerr << "Repetitions and query rows must be at least 1." << endl;
+        return 1;
+    }
+
+    initContext(ctx, 0);
+    if (not populateDex(ctx, argv[1], error)) {
+        cerr << argv[1] << ": " << error << "." << endl;
+        return 1;
+    }
+
+    benchMemory(ctx);
+    benchStatTable(ctx, reps);
+    benchTournament(ctx, reps);
+    benchQuery(ctx, reps, queryRows);
+
+    if (not benchEstimates(ctx)) {
+        cerr << "Estimated odds disagree with the exact ones." << endl;
+        return 1;
+    }
+    if (not benchAllocations(ctx, reps)) {
+        cerr << "A simulation loop allocated on the heap." << endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+/*
+ *  benchMemory()
+ *
+ *  Parameters: context with loaded Pokédex
+ *  Does:       Reports bytes per species and in total for each layout.
+ *              Strings too long for the small-string buffer are counted
+ *              with their heap allocation.
+ *  Returns:    NA
+ */
+void benchMemory(const SimContext &ctx)
+{
+    unsigned long count = ctx.pokedex.size();
+    unsigned long heap = 0;
+    unsigned long names = 0;
+
+    for (unsigned long i = 0; i < count; i++) {
+        const Pokemon &mon = ctx.pokedex[i];
+        string empty;
+
+        if (mon.name.capacity() > empty.capacity())
+            heap += mon.name.capacity() + 1;
+        if (mon.type.capacity() > empty.capacity())
+            heap += mon.type.capacity() + 1;
+    }
+
+    const StringTable &table = ctx.columns.names;
+    for (unsigned long i = 0; i < table.strings.size(); i++)
+        names += sizeof(string) + table.strings[i].size() + 1;
+
+    unsigned long columns = count * (5 * sizeof(uint16_t)
+                                     + 2 * sizeof(uint8_t));
+
+    cout << "------ MEMORY (" << count << " species) ------" << endl;
+    cout << "Pokemon struct:   " << sizeof(Pokemon) << " bytes/species, "
+         << count * sizeof(Pokemon) + heap << " bytes total ("
+         << heap << " on heap)" << endl;
+    cout << "MonRecord:        " << sizeof(MonRecord) << " bytes/species, "
+         << count * sizeof(MonRecord) << " bytes total" << endl;
+    cout << "DexColumns:       " << columns / count << " bytes/species, "
+         << columns << " bytes total (+" << names
+         << " interned name bytes)" << endl;
+}
+
+/*
+ *  benchStatTable()
+ *
+ *  Parameters: context with loaded Pokédex, repetitions
+ *  Does:       Computes every species' rounded stats at every level, as
+ *              stats does, from the Pokemon structs and from the columns.
+ *              Prints the throughput and a checksum of each, which must
+ *              agree.
+ *  Returns:    NA
+ */
+void benchStatTable(const SimContext &ctx, int reps)
+{
+    const vector<Pokemon> &dex = ctx.pokedex;
+    const DexColumns &cols = ctx.columns;
+    unsigned long count = dex.size();
+    long aosSum = 0, soaSum = 0;
+
+    auto start = chrono::steady_clock::now();
+    for (int r = 0; r < reps; r++) {
+        for (unsigned long i = 0; i < count; i++) {
+            for (int level = 1; level <= MAX_LEVEL; level++) {
+                aosSum += roundStat(dex[i].HP * level)
+                        + roundStat(dex[i].attack * level)
+                        + roundStat(dex[i].defense * level)
+                        + roundStat(dex[i].speed * level);
+            }
+        }
+    }
+    double aosTime = elapsed(start);
+
+    start = chrono::steady_clock::now();
+    for (int r = 0; r < reps; r++) {
+        for (int level = 1; level <= MAX_LEVEL; level++) {
+            for (unsigned long i = 0; i < count; i++) {
+                soaSum += roundStat(cols.HP[i] * level)
+                        + roundStat(cols.attack[i] * level)
+                        + roundStat(cols.defense[i] * level)
+                        + roundStat(cols.speed[i] * level);
+            }
+        }
+    }
+    double soaTime = elapsed(start);
+
+    double rows = (double)reps * count * MAX_LEVEL;
+
+    cout << "\n------ STAT TABLE (" << count << " species x " << MAX_LEVEL
+         << " levels x " << reps << ") ------" << endl;
+    cout << "Pokemon structs:  " << rows / aosTime / 1e6 << " M rows/s"
+         << " (checksum " << aosSum << ")" << endl;
+    cout << "DexColumns:       " << rows / soaTime / 1e6 << " M rows/s"
+         << " (checksum " << soaSum << ")" << endl;
+}
+
+/*
+ *  benchTournament()
+ *
+ *  Parameters: context with loaded Pokédex, repetitions
+ *  Does:       Classifies every ordered pair of species at
+ *              TOURNAMENT_LEVEL, once by copying Pokemon structs and
+ *              comparing type names, once from compact records. Prints the
+ *              throughput and a checksum of each, which must agree.
+ *  Returns:    NA
+ */
+void benchTournament(const SimContext &ctx, int reps)
+{
+    const vector<Pokemon> &dex = ctx.pokedex;
+    unsigned long count = dex.size();
+    long aosSum = 0, soaSum = 0;
+
+    auto start = chrono::steady_clock::now();
+    for (int r = 0; r < reps; r++) {
+        for (unsigned long a = 0; a < count; a++) {
+            Pokemon attacker = levelStats(dex[a], TOURNAMENT_LEVEL);
+
+            for (unsigned long d = 0; d < count; d++) {
+                MatchupClass matchup = classifyMatchup(attacker,
+                                           levelStats(dex[d], TOURNAMENT_LEVEL),
+                                           ctx.typeChart);
+                aosSum += matchup.atkHits + matchup.defHits + matchup.atkFirst;
+            }
+        }
+    }
+    double aosTime = elapsed(start);
+
+    start = chrono::steady_clock::now();
+    for (int r = 0; r < reps; r++) {
+        for (unsigned long a = 0; a < count; a++) {
+            MonRecord attacker = makeRecord(ctx.columns, a, TOURNAMENT_LEVEL);
+
+            for (unsigned long d = 0; d < count; d++) {
+                MatchupClass matchup = classifyRecords(attacker,
+                                           makeRecord(ctx.columns, d,
+                                                      TOURNAMENT_LEVEL),
+                                           ctx.typeChart);
+                soaSum += matchup.atkHits + matchup.defHits + matchup.atkFirst;
+            }
+        }
+    }
+    double soaTime = elapsed(start);
+
+    double pairs = (double)reps * count * count;
+
+    cout << "\n------ TOURNAMENT (" << count << " x " << count << " at LV. "
+         << TOURNAMENT_LEVEL << " x " << reps << ") ------" << endl;
+    cout << "Pokemon structs:  " << pairs / aosTime / 1e6 << " M pairs/s"
+         << " (checksum " << aosSum << ")" << endl;
+    cout << "MonRecords:       " << pairs / soaTime / 1e6 << " M pairs/s"
+         << " (checksum " << soaSum << ")" << endl;
+}
+
+/*
+ *  benchQuery()
+ *
+ *  Parameters: context with loaded Pokédex, repetitions, rows to query
+ *  Does:       Repeats the Pokédex columns to the given rows, with every
+ *              copy's stats nudged so the copies are not identical, indexes
+ *              them, and times a broad query (counted by scanning blocks)
+ *              and a selective one (answered from a filter's sorted run
+ *              within its type).
+ *  Returns:    NA
+ */
+void benchQuery(const SimContext &ctx, int reps, unsigned long queryRows)
+{
+    static const char *broad[] = {"type=fire,water", "speed>80", "level=40",
+                                  "evol>=36", "sort=-speed", "limit=10"};
+    static const char *narrow[] = {"type=ghost", "speed>120", "hp<130",
+                                   "level=40", "sort=-attack", "limit=10"};
+    const DexColumns &dex = ctx.columns;
+    unsigned long count = dex.HP.size();
+    DexColumns cols;
+    DexIndex index;
+
+    cols.HP.resize(queryRows);
+    cols.attack.resize(queryRows);
+    cols.defense.resize(queryRows);
+    cols.speed.resize(queryRows);
+    cols.name.resize(queryRows);
+    cols.type.resize(queryRows);
+    cols.nextEvol.resize(queryRows);
+
+    for (unsigned long i = 0; i < queryRows; i++) {
+        unsigned long j = i % count;
+        int nudge = (i / count) % STAT_SCALE;
+
+        cols.HP[i]       = dex.HP[j] + nudge;
+        cols.attack[i]   = dex.attack[j] + nudge;
+        cols.defense[i]  = dex.defense[j] + nudge;
+        cols.speed[i]    = dex.speed[j] + nudge;
+        cols.name[i]     = dex.name[j];
+        cols.type[i]     = dex.type[j];
+        cols.nextEvol[i] = dex.nextEvol[j];
+    }
+
+    auto start = chrono::steady_clock::now();
+    buildDexIndex(index, cols);
+    double buildTime = elapsed(start);
+
+    cout << "\n------ QUERY (" << queryRows << " rows x " << reps
+         << ") ------" << endl;
+    cout << "Build index:      " << buildTime * 1e3 << " ms" << endl;
+
+    for (int q = 0; q < 2; q++) {
+        const char **terms = (q == 0) ? broad : narrow;
+        int size = 6;
+        DexQuery query;
+        vector<uint32_t> rows;
+        string error;
+        unsigned long matches = 0;
+
+        parseQuery(vector<string>(terms, terms + size), query, error);
+
+        start = chrono::steady_clock::now();
+        for (int r = 0; r < reps; r++)
+            runQuery(index, cols, query, rows);
+        double findTime = elapsed(start);
+
+        start = chrono::steady_clock::now();
+        for (int r = 0; r < reps; r++)
+            matches = countQuery(index, cols, query);
+        double countTime = elapsed(start);
+
+        cout << ((q == 0) ? "Broad query:      " : "Selective query:  ")
+             << findTime / reps * 1e6 << " us to find " << rows.size()
+             << ", " << countTime / reps * 1e6 << " us to count "
+             << matches << endl;
+    }
+}
+
+/*
+ *  benchEstimates()
+ *
+ *  Parameters: context with loaded Pokédex
+ *  Does:       Estimates each of LONG_MATCHUPS with a fixed seed and checks
+ *              that its exact win probability lies within the estimate's
+ *              interval. Matchups whose species are not in the Pokédex are
+ *              skipped.
+ *  Returns:    True if every estimate agrees
+ */
+bool benchEstimates(const SimContext &ctx)
+{
+    mt19937 rng(CHECK_SEED);
+    bool agree = true;
+
+    cout << "\n------ ESTIMATES (long matchups) ------" << endl;
+
+    for (int i = 0; i < LONG_MATCHUP_COUNT; i++) {
+        const LongMatchup &check = LONG_MATCHUPS[i];
+        int a = searchDex(ctx, check.attacker);
+        int d = searchDex(ctx, check.defender);
+        if (a < 0 or d < 0)
+            continue;
+
+        Pokemon attacker = levelStats(ctx.pokedex[a], check.atkLevel);
+        Pokemon defender = levelStats(ctx.pokedex[d], check.defLevel);
+        double exact = winProbability(classifyMatchup(attacker, defender,
+                                                      ctx.typeChart));
+        MatchupResult odds = simulateMatchup(attacker, defender,
+                                             ctx.typeChart, CHECK_PRECISION,
+                                             CHECK_CONFIDENCE, rng);
+        bool within = fabs(odds.winProb - exact) <= odds.halfWidth;
+
+        cout << check.attacker << " L" << check.atkLevel << " vs "
+             << check.defender << " L" << check.defLevel << ": exact "
+             << exact << ", estimated " << odds.winProb << " ± "
+             << odds.halfWidth << " (" << odds.expTurns << " turns)"
+             << (within ? "" : "  <-- disagrees") << endl;
+        agree = agree and within;
+    }
+
+    return agree;
+}
+
+/*
+ *  benchAllocations()
+ *
+ *  Parameters: context with loaded Pokédex, repetitions
+ *  Does:       Runs the steady-state loops of the simulators (spawning and
+ *              battling, as catch and jobs do; battling into a fresh turn
+ *              log reserved as battle does; exact and estimated matchup
+ *              odds; and Pokédex queries) once to warm up, then counts the
+ *              heap allocations of the given repetitions. Uses the whole
+ *              Pokédex at level 1 as the route.
+ *  Returns:    True if no loop allocated beyond one reservation per logged
+ *              battle (or counting is not compiled in)
+ */
+bool benchAllocations(SimContext &ctx, int reps)
+{
+    static const char *terms[] = {"type=fire,water", "speed>80", "level=40",
+                                  "sort=-speed", "limit=10"};
+    unsigned long count = ctx.pokedex.size();
+    Pokemon trainer = levelStats(ctx.pokedex[0], TOURNAMENT_LEVEL);
+    Pokemon encounter;
+    DexIndex index;
+    DexQuery query;
+    vector<uint32_t> rows;
+    string error;
+    unsigned long before = 0;
+    bool clean = true;
+    long sum = 0;
+    double odds = 0;
+
+    cout << "\n------ ALLOCATIONS (after warm-up, x " << reps << ") ------"
+         << endl;
+    if (not COUNTING_ALLOCS) {
+        cout << "Not counted (build with CPPFLAGS=-DPOKESIM_COUNT_ALLOCS)"
+             << endl;
+        return true;
+    }
+
+    ctx.route = ctx.pokedex;
+    ctx.range.low = 1;
+    ctx.range.high = MAX_LEVEL;
+    buildDexIndex(index, ctx.columns);
+    parseQuery(vector<string>(terms, terms + 5), query, error);
+
+    for (int r = 0; r <= reps; r++) {
+        if (r == 1)
+            before = allocationCount();
+        for (unsigned long i = 0; i < count; i++) {
+            spawn(ctx, encounter);
+            sum += battle(ctx, trainer, encounter, NULL).turns;
+        }
+    }
+    clean = reportAllocations("Spawn & battle:", before, 0) and clean;
+
+    for (int r = 0; r <= reps; r++) {
+        if (r == 1)
+            before = allocationCount();
+        for (unsigned long i = 0; i < count; i++) {
+            // As battle.cpp does: only the reservation may allocate
+            vector<TurnEvent> log;
+            log.reserve(LOG_TURNS);
+            spawn(ctx, encounter);
+            battle(ctx, trainer, encounter, &log);
+            sum += log.size();
+        }
+    }
+    clean = reportAllocations("Logged battle:", before, reps * count)
+            and clean;
+
+    for (int r = 0; r <= reps; r++) {
+        if (r == 1)
+            before = allocationCount();
+        for (unsigned long a = 0; a < count; a++) {
+            MonRecord attacker = makeRecord(ctx.columns, a, TOURNAMENT_LEVEL);
+
+            for (unsigned long d = a % EXACT_STRIDE; d < count;
+                 d += EXACT_STRIDE) {
+                MonRecord defender = makeRecord(ctx.columns, d,
+                                                TOURNAMENT_LEVEL);
+                odds += winProbability(classifyRecords(attacker, defender,
+                                                       ctx.typeChart));
+            }
+        }
+    }
+    clean = reportAllocations("Exact odds:", before, 0) and clean;
+
+    for (int r = 0; r <= reps; r++) {
+        if (r == 1)
+            before = allocationCount();
+        for (unsigned long i = 0; i < count; i++) {
+            spawn(ctx, encounter);
+            odds += simulateMatchup(trainer, encounter, ctx.typeChart,
+                                    ESTIMATE_PRECISION, ESTIMATE_CONFIDENCE,
+                                    ctx.rng).winProb;
+        }
+    }
+    clean = reportAllocations("Estimated odds:", before, 0) and clean;
+
+    for (int r = 0; r <= reps; r++) {
+        if (r == 1)
+            before = allocationCount();
+        runQuery(index, ctx.columns, query, rows);
+        sum += rows.size() + countQuery(index, ctx.columns, query);
+    }
+    clean = reportAllocations("Query:", before, 0) and clean;
+
+    cout << "(checksums " << sum << ", " << odds << ")" << endl;
+
+    return clean;
+}
+
+/*
+ *  reportAllocations()
+ *
+ *  Parameters: name of the loop, allocation count before it, number of
+ *              allocations the loop is meant to make
+ *  Does:       Prints how many heap allocations the loop made.
+ *  Returns:    True if it made exactly the expected number
+ */
+bool reportAllocations(const char *phase, unsigned long before,
+                       unsigned long expected)
+{
+    unsigned long made = allocationCount() - before;
+
+    cout << left << setw(18) << phase << made;
+    if (expected != 0)
+        cout << " (expected " << expected << ")";
+    cout << (made == expected ? "" : "  <-- allocates") << endl;
+
+    return made == expected;
+}
+
+/*
+ *  elapsed()
+ *
+ *  Parameters: start time
+ *  Does:       Measures time since start.
+ *  Returns:    Elapsed seconds
+ */
+double elapsed(chrono::steady_clock::time_point start)
+{
+    chrono::duration<double> span = chrono::steady_clock::now() - start;
+
+    return span.count();
+}
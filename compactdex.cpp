@@ -0,0 +1,179 @@
+/*
+ *      compactdex.cpp
+ *
+ *      Purpose: Builds the compact (16-byte record, structure of arrays)
+ *               Pokédex from the regular one, and classifies matchups
+ *               directly from compact records without touching strings.
+ *
+ *      Last modified: October 19, 2026
+ */
+
+#include <cstring>
+#include <stdexcept>
+
+#include "compactdex.h"
+
+using namespace std;
+
+/*
+ *  internString()
+ *
+ *  Parameters: string table, string to intern
+ *  Does:       Adds the string to the table if it is not there yet. Throws
+ *              overflow_error if the table has run out of 16-bit IDs.
+ *  Returns:    The string's ID
+ */
+uint16_t internString(StringTable &table, const string &str)
+{
+    auto found = table.ids.find(str);
+    if (found != table.ids.end())
+        return found->second;
+
+    if (table.strings.size() > UINT16_MAX)
+        throw overflow_error("more than 65536 distinct names to intern");
+
+    uint16_t id = table.strings.size();
+    table.strings.push_back(str);
+    table.ids[str] = id;
+
+    return id;
+}
+
+/*
+ *  buildColumns()
+ *
+ *  Parameters: Pokédex, columns to fill
+ *  Does:       Fills one column per field of the Pokédex, interning names.
+ *              Throws overflow_error if a value does not fit its column.
+ *  Returns:    NA
+ */
+void buildColumns(const vector<Pokemon> &pokedex, DexColumns &columns)
+{
+    unsigned long size = pokedex.size();
+
+    columns.HP.resize(size);
+    columns.attack.resize(size);
+    columns.defense.resize(size);
+    columns.speed.resize(size);
+    columns.name.resize(size);
+    columns.type.resize(size);
+    columns.nextEvol.resize(size);
+
+    for (unsigned long i = 0; i < size; i++) {
+        const Pokemon &mon = pokedex[i];
+
+        columns.HP[i]       = narrowStat(mon.HP, mon.name, "HP");
+        columns.attack[i]   = narrowStat(mon.attack, mon.name, "attack");
+        columns.defense[i]  = narrowStat(mon.defense, mon.name, "defense");
+        columns.speed[i]    = narrowStat(mon.speed, mon.name, "speed");
+        columns.name[i]     = internString(columns.names, mon.name);
+        columns.type[i]     = typeIndex(mon.type);
+        columns.nextEvol[i] = narrowByte(mon.nextEvol, mon.name,
+                                         "evolution level");
+    }
+}
+
+/*
+ *  makeRecord()
+ *
+ *  Parameters: Pokédex columns, index of Pokémon, level
+ *  Does:       Gathers one Pokémon's columns into a compact record.
+ *              Throws overflow_error if the level does not fit a byte.
+ *  Returns:    The Pokémon's record at the given level
+ */
+MonRecord makeRecord(const DexColumns &columns, int index, int level)
+{
+    MonRecord record;
+
+    memset(&record, 0, sizeof(record));
+    record.HP       = columns.HP[index];
+    record.attack   = columns.attack[index];
+    record.defense  = columns.defense[index];
+    record.speed    = columns.speed[index];
+    record.name     = columns.name[index];
+    record.type     = columns.type[index];
+    record.nextEvol = columns.nextEvol[index];
+    record.level    = narrowByte(level, columns.names.strings[record.name],
+                                 "level");
+
+    return record;
+}
+
+/*
+ *  narrowStat(), narrowByte()
+ *
+ *  Parameters: stat (units of 1/STAT_SCALE) / byte-sized value, name of
+ *              its Pokémon, name of the field
+ *  Does:       Checks that the value fits a 16-bit / 8-bit field, throwing
+ *              overflow_error naming the Pokémon and field if it does not.
+ *  Returns:    The narrowed value
+ */
+uint16_t narrowStat(int stat, const string &name, const char *field)
+{
+    if (stat < 0 or stat > UINT16_MAX)
+        throw overflow_error(name + ": " + field + " does not fit 16 bits");
+
+    return stat;
+}
+
+uint8_t narrowByte(int value, const string &name, const char *field)
+{
+    if (value < 0 or value > UINT8_MAX)
+        throw overflow_error(name + ": " + field + " does not fit 8 bits");
+
+    return value;
+}
+
+/*
+ *  expandRecord()
+ *
+ *  Parameters: Pokédex columns (for the name table), compact record
+ *  Does:       Converts a record back into a regular Pokémon with stats at
+ *              the record's level.
+ *  Returns:    The expanded Pokémon
+ */
+Pokemon expandRecord(const DexColumns &columns, const MonRecord &record)
+{
+    Pokemon mon;
+
+    mon.name     = columns.names.strings[record.name];
+    mon.HP       = record.HP * record.level;
+    mon.attack   = record.attack * record.level;
+    mon.defense  = record.defense * record.level;
+    mon.speed    = record.speed * record.level;
+    mon.type     = typeName(record.type);
+    mon.nextEvol = record.nextEvol;
+
+    return mon;
+}
+
+/*
+ *  classifyRecords()
+ *
+ *  Parameters: attacking and defending Pokémon's records, type chart
+ *  Does:       Same as classifyMatchup(), reading types straight from the
+ *              records instead of comparing type names.
+ *  Returns:    The matchup's class
+ */
+MatchupClass classifyRecords(const MonRecord &attacker,
+                             const MonRecord &defender,
+                             const vector< vector<int> > &typeChart)
+{
+    MatchupClass matchup;
+
+    int atkHP  = attacker.HP      * attacker.level;
+    int atkAtk = attacker.attack  * attacker.level;
+    int atkDef = attacker.defense * attacker.level;
+    int defHP  = defender.HP      * defender.level;
+    int defAtk = defender.attack  * defender.level;
+    int defDef = defender.defense * defender.level;
+
+    matchup.atkHits = hitsToKO(defHP, hitDamage(atkAtk, defDef,
+                               typeChart[attacker.type][defender.type]));
+    matchup.defHits = hitsToKO(atkHP, hitDamage(defAtk, atkDef,
+                               typeChart[defender.type][attacker.type]));
+    matchup.atkFirst = attacker.speed * attacker.level
+                       > defender.speed * defender.level;
+
+    return matchup;
+}
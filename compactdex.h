@@ -0,0 +1,89 @@
+/*
+ *      compactdex.h
+ *
+ *      Purpose: Compact representation of Pokémon for hot paths. Names are
+ *               interned to 16-bit IDs, types stored as their type chart
+ *               index, and stats as 16-bit fixed-point numbers, so a single
+ *               Pokémon fits in a 16-byte record with no heap allocations.
+ *               The Pokédex is also kept as a structure of arrays, so scans
+ *               over every species stream through contiguous memory.
+ *               Values that do not fit their field (more than 65,536
+ *               distinct names, a base stat over 65,535/STAT_SCALE, or an
+ *               evolution level or level over 255) throw overflow_error
+ *               rather than wrap.
+ *
+ *      Last modified: October 19, 2026
+ */
+
+#ifndef COMPACTDEX_H
+#define COMPACTDEX_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "pokemon.h"
+#include "matchup.h"
+
+/*
+ * StringTable
+ *
+ * Interns strings: each distinct string is stored once and referred to by
+ * its 16-bit ID.
+ */
+struct StringTable {
+    std::vector<std::string> strings;
+    std::unordered_map<std::string, uint16_t> ids;
+};
+
+/*
+ * MonRecord
+ *
+ * A Pokémon in 16 bytes: base (level 1) stats in units of 1/STAT_SCALE,
+ * interned name, type chart index, level of next evolution, and current
+ * level.
+ */
+struct MonRecord {
+    uint16_t HP;
+    uint16_t attack;
+    uint16_t defense;
+    uint16_t speed;
+    uint16_t name;
+    uint8_t type;
+    uint8_t nextEvol;
+    uint8_t level;
+    uint8_t reserved[3];
+};
+
+static_assert(sizeof(MonRecord) == 16, "MonRecord must stay 16 bytes");
+
+/*
+ * DexColumns
+ *
+ * The Pokédex as a structure of arrays: one contiguous column per field,
+ * indexed the same as the Pokédex vector.
+ */
+struct DexColumns {
+    std::vector<uint16_t> HP;
+    std::vector<uint16_t> attack;
+    std::vector<uint16_t> defense;
+    std::vector<uint16_t> speed;
+    std::vector<uint16_t> name;
+    std::vector<uint8_t> type;
+    std::vector<uint8_t> nextEvol;
+    StringTable names;
+};
+
+uint16_t internString(StringTable &table, const std::string &str);
+uint16_t narrowStat(int stat, const std::string &name, const char *field);
+uint8_t narrowByte(int value, const std::string &name, const char *field);
+
+void buildColumns(const std::vector<Pokemon> &pokedex, DexColumns &columns);
+MonRecord makeRecord(const DexColumns &columns, int index, int level);
+Pokemon expandRecord(const DexColumns &columns, const MonRecord &record);
+MatchupClass classifyRecords(const MonRecord &attacker,
+                             const MonRecord &defender,
+                             const std::vector< std::vector<int> > &typeChart);
+
+#endif
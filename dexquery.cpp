@@ -0,0 +1,979 @@
+/*
+ *      dexquery.cpp
+ *
+ *      Purpose: Builds the query index over the columnar Pokédex, parses
+ *               query expressions, and plans and runs them. Each filter is
+ *               turned into a range of raw column values, so a filter's
+ *               matches are a contiguous run of its sorted column, overall or
+ *               within one type. The first rows in sort order are found by
+ *               walking each allowed type's rows in sort order until the
+ *               limit is reached, or by checking only the rows the most
+ *               selective filter allows among the allowed types; counting
+ *               every match does the latter or evaluates every filter over
+ *               blocks of 64 rows into bitmaps.
+ *
+ *      Last modified: October 19, 2026
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#include "dexquery.h"
+#include "pokesim.h"
+
+using namespace std;
+
+/* A filter's run of the sorted column is checked row by row when it holds
+ * fewer than 1 in GATHER_RATIO rows; otherwise every row is scanned. A walk
+ * in sort order gives up after WALK_SLACK times its estimated rows (plus
+ * WALK_MIN_ROWS), since filters correlated with the sort column can make
+ * the estimate far too low. */
+const unsigned long GATHER_RATIO = 16;
+const double WALK_SLACK = 4;
+const double WALK_MIN_ROWS = 64;
+const int STAT_MAX = 65535;
+const int NO_DRIVER = -1;
+const int TYPE_DRIVER = -2;
+const int ANY_TYPE = -1;
+const uint64_t PACK_BITS = 0x0102040810204080ull;
+
+/*
+ * ColumnRange
+ *
+ * A filter as an inclusive range of raw column values (base stats in units
+ * of 1/STAT_SCALE, or evolution keys), or its complement if negated.
+ */
+struct ColumnRange {
+    int column;
+    int low;
+    int high;
+    bool negated;
+};
+
+/*
+ * QueryPlan
+ *
+ * How a query will run: its filters as column ranges, its driver (the type
+ * bitmaps, a filter's index, whose sorted runs within the allowed types are
+ * checked, or none) and how many rows the driver allows, its estimated
+ * selectivity, the share of rows of the allowed types, and those types'
+ * bitmaps (none if any type is allowed).
+ */
+struct QueryPlan {
+    ColumnRange ranges[MAX_FILTERS];
+    int rangeCount;
+    const uint64_t *typeBits[TYPE_COUNT];
+    int typeCount;
+    int driver;
+    unsigned long fewest;
+    double selectivity;
+    double typeShare;
+};
+
+/*
+ * WalkRun
+ *
+ * A run of rows to walk in sort order: positions [first, last) of a sorted
+ * column (overall or grouped by type), or of Pokédex order if order is
+ * NULL.
+ */
+struct WalkRun {
+    const std::vector<uint32_t> *order;
+    unsigned long first;
+    unsigned long last;
+};
+
+bool planQuery(const DexIndex &index, const DexColumns &columns,
+               const DexQuery &query, QueryPlan &plan);
+int walkRuns(const DexIndex &index, const DexColumns &columns,
+             const DexQuery &query, const QueryPlan &plan, WalkRun runs[]);
+bool walkRows(const DexIndex &index, const DexColumns &columns,
+              const DexQuery &query, const QueryPlan &plan,
+              const WalkRun runs[], int runCount, unsigned long budget,
+              vector<uint32_t> &rows);
+unsigned long gatherRows(const DexIndex &index, const DexColumns &columns,
+                         const DexQuery &query, const QueryPlan &plan,
+                         vector<uint32_t> *rows);
+bool typeAllowed(uint32_t types, int type);
+const vector<uint32_t> &sortedOrder(const DexIndex &index, int column,
+                                    int type);
+unsigned long runRows(const DexIndex &index, const DexColumns &columns,
+                      uint32_t types, const ColumnRange &range);
+int columnValue(const DexIndex &index, const DexColumns &columns,
+                int column, uint32_t row);
+int minBase(int value, int level);
+ColumnRange toRange(const StatFilter &filter, int level);
+void sortedRun(const DexIndex &index, const DexColumns &columns,
+               const ColumnRange &range, int type, unsigned long &first,
+               unsigned long &last);
+bool rowMatches(const DexIndex &index, const DexColumns &columns,
+                uint32_t types, const ColumnRange ranges[], int rangeCount,
+                uint32_t row);
+uint64_t blockMatches(const DexIndex &index, const DexColumns &columns,
+                      const QueryPlan &plan, unsigned long block);
+unsigned long scanBlocks(const DexIndex &index, const DexColumns &columns,
+                         const QueryPlan &plan);
+bool parseNumber(const string &text, int &value);
+int parseColumn(const string &name);
+
+/*
+ *  blockMask()
+ *
+ *  Parameters: a column's values for one block of rows, inclusive range
+ *              (non-empty, within the column's type), number of rows in
+ *              the block (at most 64)
+ *  Does:       Tests every row of the block against the range with one
+ *              unsigned comparison each in the column's own width, into
+ *              one byte per row, in a branch-free loop the compiler
+ *              vectorizes. Each 8 bytes are then packed into 8 bits with
+ *              one multiplication (PACK_BITS moves byte i's low bit to bit
+ *              56 + i; bytes are read little-endian).
+ *  Returns:    Bitmap of the block's rows in range
+ */
+template <typename T>
+uint64_t blockMask(const T *values, int low, int high, int count)
+{
+    T base = low;
+    T span = high - low;
+    uint8_t hits[64] = {0};
+    uint64_t mask = 0;
+
+    // A fixed trip count lets even -O2 vectorize full blocks
+    if (count == 64) {
+        for (int i = 0; i < 64; i++)
+            hits[i] = (T)(values[i] - base) <= span;
+    } else {
+        for (int i = 0; i < count; i++)
+            hits[i] = (T)(values[i] - base) <= span;
+    }
+
+    for (int i = 0; i < 8; i++) {
+        uint64_t bytes;
+        memcpy(&bytes, hits + 8 * i, sizeof(bytes));
+        mask |= (bytes * PACK_BITS) >> 56 << (8 * i);
+    }
+
+    return mask;
+}
+
+/*
+ *  buildDexIndex()
+ *
+ *  Parameters: index to build, Pokédex columns
+ *  Does:       Maps evolution levels to keys, sets each row's bit in its
+ *              type's bitmap, and sorts the row IDs by every column. Each
+ *              sorted column is then split by type, keeping its order
+ *              within each type.
+ *  Returns:    NA
+ */
+void buildDexIndex(DexIndex &index, const DexColumns &columns)
+{
+    unsigned long rows = columns.HP.size();
+    unsigned long blocks = (rows + 63) / 64;
+
+    index.rows = rows;
+    index.evolKey.resize(rows);
+    index.typeBits.assign(TYPE_COUNT, vector<uint64_t>(blocks, 0));
+    index.typeRows.assign(TYPE_COUNT, 0);
+    index.typeStart.assign(TYPE_COUNT + 1, 0);
+
+    for (unsigned long i = 0; i < rows; i++) {
+        int evol = columns.nextEvol[i];
+
+        index.evolKey[i] = (evol == 0) ? NEVER_EVOLVES : evol;
+        index.typeBits[columns.type[i]][i / 64] |= (uint64_t)1 << (i % 64);
+        index.typeRows[columns.type[i]]++;
+    }
+
+    for (int t = 0; t < TYPE_COUNT; t++)
+        index.typeStart[t + 1] = index.typeStart[t] + index.typeRows[t];
+
+    for (int column = 0; column < DEX_COLUMNS; column++) {
+        vector<uint32_t> &order = index.sorted[column];
+        vector<uint32_t> &grouped = index.typeSorted[column];
+        vector<unsigned long> next(index.typeStart.begin(),
+                                   index.typeStart.end() - 1);
+
+        order.resize(rows);
+        for (unsigned long i = 0; i < rows; i++)
+            order[i] = i;
+
+        stable_sort(order.begin(), order.end(),
+                    [&](uint32_t a, uint32_t b) {
+                        return columnValue(index, columns, column, a)
+                               < columnValue(index, columns, column, b);
+                    });
+
+        grouped.resize(rows);
+        for (unsigned long i = 0; i < rows; i++)
+            grouped[next[columns.type[order[i]]]++] = order[i];
+    }
+}
+
+/*
+ *  parseQuery()
+ *
+ *  Parameters: query terms, query to populate, error message to populate
+ *  Does:       Parses terms of the form
+ *                type=fire,water          any of the listed types
+ *                speed>80                 hp, attack, defense, speed, or
+ *                                         evol with =, !=, <, <=, >, >=
+ *                level=40                 level stats are compared at
+ *                sort=-speed              sort column, - for descending
+ *                limit=10                 most rows to return
+ *              An evol value of 0 means "never evolves", which compares
+ *              above every evolution level (evol>=36 includes species that
+ *              never evolve). Stats default to level 1, results to
+ *              Pokédex order, and the limit to DEFAULT_QUERY_LIMIT.
+ *  Returns:    True if every term parsed, otherwise false with an error
+ */
+bool parseQuery(const vector<string> &terms, DexQuery &query, string &error)
+{
+    query.types = 0;
+    query.filters.clear();
+    query.level = 1;
+    query.sortColumn = -1;
+    query.descending = false;
+    query.limit = DEFAULT_QUERY_LIMIT;
+
+    for (unsigned long i = 0; i < terms.size(); i++) {
+        const string &term = terms[i];
+        size_t opStart = term.find_first_of("=!<>");
+        size_t opEnd = term.find_first_not_of("=!<>", opStart);
+
+        if (opStart == string::npos or opStart == 0 or opEnd == string::npos) {
+            error = "cannot parse \"" + term + "\"";
+            return false;
+        }
+
+        string name = term.substr(0, opStart);
+        string op = term.substr(opStart, opEnd - opStart);
+        string value = term.substr(opEnd);
+
+        if (name == "type" or name == "level" or name == "sort"
+            or name == "limit") {
+            if (op != "=") {
+                error = name + " only takes =";
+                return false;
+            }
+        }
+
+        if (name == "type") {
+            size_t start = 0;
+            while (start <= value.size()) {
+                size_t end = value.find(',', start);
+                if (end == string::npos)
+                    end = value.size();
+
+                string type = value.substr(start, end - start);
+                int typeId = typeIndex(type);
+                if (typeId == 0 and type != "normal") {
+                    error = "unknown type \"" + type + "\"";
+                    return false;
+                }
+
+                query.types |= (uint32_t)1 << typeId;
+                start = end + 1;
+            }
+        } else if (name == "level") {
+            if (not parseNumber(value, query.level) or query.level < 1
+                or query.level > 100) {
+                error = "level must be 1 - 100";
+                return false;
+            }
+        } else if (name == "limit") {
+            if (not parseNumber(value, query.limit) or query.limit < 1) {
+                error = "limit must be at least 1";
+                return false;
+            }
+        } else if (name == "sort") {
+            query.descending = (value[0] == '-');
+            query.sortColumn = parseColumn(value.substr(query.descending));
+            if (query.sortColumn == -1) {
+                error = "unknown sort column \"" + value + "\"";
+                return false;
+            }
+        } else {
+            StatFilter filter;
+
+            filter.column = parseColumn(name);
+            if (filter.column == -1) {
+                error = "unknown column \"" + name + "\"";
+                return false;
+            }
+
+            if (op == "=")       filter.op = OP_EQ;
+            else if (op == "!=") filter.op = OP_NE;
+            else if (op == "<")  filter.op = OP_LT;
+            else if (op == "<=") filter.op = OP_LE;
+            else if (op == ">")  filter.op = OP_GT;
+            else if (op == ">=") filter.op = OP_GE;
+            else {
+                error = "unknown comparison \"" + op + "\"";
+                return false;
+            }
+
+            if (not parseNumber(value, filter.value)) {
+                error = "\"" + value + "\" is not a number";
+                return false;
+            }
+            if (filter.column == COL_EVOL and filter.value == 0)
+                filter.value = NEVER_EVOLVES;
+            if ((int)query.filters.size() == MAX_FILTERS) {
+                error = "more than " + to_string(MAX_FILTERS) + " filters";
+                return false;
+            }
+
+            query.filters.push_back(filter);
+        }
+    }
+
+    return true;
+}
+
+/*
+ *  runQuery()
+ *
+ *  Parameters: query index, Pokédex columns, parsed query, row IDs to
+ *              populate
+ *  Does:       Finds the first matching rows in the query's order, up to
+ *              its limit, by whichever is expected to be cheaper:
+ *                - walking each allowed type's rows in sort order
+ *                  (restricted to the sort column's own filter) and
+ *                  stopping at the limit, which costs about limit /
+ *                  selectivity rows per type; if the walks run well past
+ *                  that estimate, or past the cost of gathering, it
+ *                  gathers instead, so a bad estimate costs little
+ *                - checking every row the plan's driver allows and
+ *                  partially sorting the hits
+ *              Without a sort column, Pokédex order is walked instead.
+ *              Does not count the matches; see countQuery().
+ *  Returns:    NA
+ */
+void runQuery(const DexIndex &index, const DexColumns &columns,
+              const DexQuery &query, vector<uint32_t> &rows)
+{
+    QueryPlan plan;
+    WalkRun runs[TYPE_COUNT];
+    int column = query.sortColumn;
+    unsigned long limit = query.limit;
+
+    rows.clear();
+    if (not planQuery(index, columns, query, plan))
+        return;
+
+    // Walking one type's rows, only the other filters can reject a row
+    int runCount = walkRuns(index, columns, query, plan, runs);
+    double share = (column != -1 and query.types != 0)
+                   ? plan.selectivity / plan.typeShare : plan.selectivity;
+    double walkCost = 0;
+
+    for (int i = 0; i < runCount; i++)
+        walkCost += min((double)(runs[i].last - runs[i].first),
+                        limit / max(share, 1.0 / index.rows));
+
+    double gatherCost = (plan.driver == NO_DRIVER) ? index.rows
+                                                   : plan.fewest;
+
+    double budget = min(gatherCost, WALK_SLACK * walkCost + WALK_MIN_ROWS);
+
+    if (walkCost > gatherCost
+        or not walkRows(index, columns, query, plan, runs, runCount,
+                        (unsigned long)budget, rows))
+        gatherRows(index, columns, query, plan, &rows);
+
+    auto before = [&](uint32_t a, uint32_t b) {
+        if (column == -1)
+            return a < b;
+
+        int valueA = columnValue(index, columns, column, a);
+        int valueB = columnValue(index, columns, column, b);
+        // Ties stay in row order either way
+        if (valueA != valueB)
+            return query.descending ? valueA > valueB : valueA < valueB;
+        return a < b;
+    };
+
+    limit = min(limit, (unsigned long)rows.size());
+    partial_sort(rows.begin(), rows.begin() + limit, rows.end(), before);
+    rows.resize(limit);
+}
+
+/*
+ *  countQuery()
+ *
+ *  Parameters: query index, Pokédex columns, parsed query
+ *  Does:       Counts every matching row. If the plan's driving filter
+ *              allows few enough rows among the allowed types, only those
+ *              are checked; otherwise the whole query is evaluated over
+ *              blocks of 64 rows into a bitmap.
+ *  Returns:    Number of matching rows
+ */
+unsigned long countQuery(const DexIndex &index, const DexColumns &columns,
+                         const DexQuery &query)
+{
+    QueryPlan plan;
+
+    if (not planQuery(index, columns, query, plan))
+        return 0;
+
+    if (plan.driver >= 0 and plan.fewest * GATHER_RATIO < index.rows)
+        return gatherRows(index, columns, query, plan, NULL);
+
+    return scanBlocks(index, columns, plan);
+}
+
+/*
+ *  planQuery()
+ *
+ *  Parameters: query index, Pokédex columns, parsed query, plan to
+ *              populate
+ *  Does:       Turns every filter into a range of raw column values and
+ *              sizes each one's sorted runs within the allowed types. The
+ *              driver is the most selective of the type bitmaps and the
+ *              filters; the selectivity estimate multiplies every filter's,
+ *              as if independent.
+ *  Returns:    False if some filter matches nothing, otherwise true
+ */
+bool planQuery(const DexIndex &index, const DexColumns &columns,
+               const DexQuery &query, QueryPlan &plan)
+{
+    plan.rangeCount = 0;
+    plan.driver = NO_DRIVER;
+    plan.fewest = index.rows;
+    plan.selectivity = 1.0;
+    plan.typeShare = 1.0;
+    plan.typeCount = 0;
+
+    if (index.rows == 0)
+        return false;
+
+    for (unsigned long i = 0; i < query.filters.size(); i++) {
+        ColumnRange range = toRange(query.filters[i], query.level);
+
+        if (range.low > range.high) {
+            if (not range.negated)
+                return false;
+            continue;
+        }
+        plan.ranges[plan.rangeCount++] = range;
+    }
+
+    if (query.types != 0) {
+        unsigned long typed = 0;
+        for (int t = 0; t < TYPE_COUNT; t++) {
+            if (not typeAllowed(query.types, t))
+                continue;
+            typed += index.typeRows[t];
+            plan.typeBits[plan.typeCount++] = index.typeBits[t].data();
+        }
+
+        plan.typeShare = (double)typed / index.rows;
+        plan.selectivity *= plan.typeShare;
+        if (typed < plan.fewest) {
+            plan.fewest = typed;
+            plan.driver = TYPE_DRIVER;
+        }
+    }
+
+    for (int i = 0; i < plan.rangeCount; i++) {
+        unsigned long first, last;
+
+        sortedRun(index, columns, plan.ranges[i], ANY_TYPE, first, last);
+        double share = (double)(last - first) / index.rows;
+
+        if (plan.ranges[i].negated) {
+            plan.selectivity *= 1 - share;
+            continue;
+        }
+
+        plan.selectivity *= share;
+
+        unsigned long allowed = (query.types == 0)
+                                ? last - first
+                                : runRows(index, columns, query.types,
+                                          plan.ranges[i]);
+        if (allowed < plan.fewest) {
+            plan.fewest = allowed;
+            plan.driver = i;
+        }
+    }
+
+    return plan.fewest > 0;
+}
+
+/*
+ *  walkRuns()
+ *
+ *  Parameters: query index, Pokédex columns, parsed query, its plan, runs
+ *              to populate (at most TYPE_COUNT)
+ *  Does:       Finds the rows to walk in the query's order: with a sort
+ *              column, its rows within each allowed type (or all rows
+ *              without a type filter), narrowed to the sort column's own
+ *              filters; without one, every row in Pokédex order.
+ *  Returns:    Number of runs
+ */
+int walkRuns(const DexIndex &index, const DexColumns &columns,
+             const DexQuery &query, const QueryPlan &plan, WalkRun runs[])
+{
+    int column = query.sortColumn;
+    int runCount = 0;
+
+    if (column == -1) {
+        runs[0].order = NULL;
+        runs[0].first = 0;
+        runs[0].last = index.rows;
+        return 1;
+    }
+
+    for (int t = ANY_TYPE; t < TYPE_COUNT; t++) {
+        if (t == ANY_TYPE ? query.types != 0
+                          : not typeAllowed(query.types, t))
+            continue;
+
+        WalkRun &run = runs[runCount++];
+        run.order = &sortedOrder(index, column, t);
+        run.first = (t == ANY_TYPE) ? 0 : index.typeStart[t];
+        run.last = (t == ANY_TYPE) ? index.rows : index.typeStart[t + 1];
+
+        for (int i = 0; i < plan.rangeCount; i++) {
+            unsigned long first, last;
+
+            if (plan.ranges[i].column != column or plan.ranges[i].negated)
+                continue;
+
+            sortedRun(index, columns, plan.ranges[i], t, first, last);
+            run.first = max(run.first, first);
+            run.last = max(run.first, min(run.last, last));
+        }
+    }
+
+    return runCount;
+}
+
+/*
+ *  walkRows()
+ *
+ *  Parameters: query index, Pokédex columns, parsed query, its plan, runs
+ *              to walk and their number, most rows to walk, row IDs to
+ *              populate
+ *  Does:       Walks each run in the query's order, keeping its first
+ *              matches up to the query's limit. Walking down a sorted run
+ *              meets tied rows in reverse row order, so a descending walk
+ *              also keeps every match tied with the last one kept.
+ *              Together they hold the first matches overall, once sorted.
+ *  Returns:    False if the walks ran past the budget (rows is then
+ *              incomplete), otherwise true
+ */
+bool walkRows(const DexIndex &index, const DexColumns &columns,
+              const DexQuery &query, const QueryPlan &plan,
+              const WalkRun runs[], int runCount, unsigned long budget,
+              vector<uint32_t> &rows)
+{
+    unsigned long limit = query.limit;
+    unsigned long walked = 0;
+
+    for (int r = 0; r < runCount; r++) {
+        const WalkRun &run = runs[r];
+        unsigned long found = 0;
+        int last = 0;
+
+        // Rows of a type's run need no type check
+        uint32_t types = (run.order == NULL) ? query.types : 0;
+
+        for (unsigned long i = run.first; i < run.last; i++) {
+            uint32_t row = i;
+            if (run.order != NULL)
+                row = query.descending
+                      ? (*run.order)[run.last - 1 - (i - run.first)]
+                      : (*run.order)[i];
+
+            if (found >= limit
+                and (not query.descending
+                     or columnValue(index, columns, query.sortColumn, row)
+                        != last))
+                break;
+
+            if (rowMatches(index, columns, types, plan.ranges,
+                           plan.rangeCount, row)) {
+                rows.push_back(row);
+                found++;
+                if (query.descending)
+                    last = columnValue(index, columns, query.sortColumn,
+                                       row);
+            }
+            if (++walked > budget)
+                return false;
+        }
+    }
+
+    return true;
+}
+
+/*
+ *  gatherRows()
+ *
+ *  Parameters: query index, Pokédex columns, parsed query, its plan, row
+ *              IDs to populate (NULL to only count them)
+ *  Does:       Checks every row the driver allows against the rest of the
+ *              query: the driving filter's sorted run within each allowed
+ *              type, or, driven by the type bitmaps (or nothing), every
+ *              block of 64 rows as in scanBlocks().
+ *  Returns:    Number of matching rows
+ */
+unsigned long gatherRows(const DexIndex &index, const DexColumns &columns,
+                         const DexQuery &query, const QueryPlan &plan,
+                         vector<uint32_t> *rows)
+{
+    unsigned long matches = 0;
+
+    if (rows != NULL)
+        rows->clear();
+
+    if (plan.driver < 0) {
+        for (unsigned long b = 0; b * 64 < index.rows; b++) {
+            uint64_t mask = blockMatches(index, columns, plan, b);
+
+            matches += __builtin_popcountll(mask);
+            for (; rows != NULL and mask != 0; mask &= mask - 1)
+                rows->push_back(b * 64 + __builtin_ctzll(mask));
+        }
+        return matches;
+    }
+
+    const ColumnRange &range = plan.ranges[plan.driver];
+    for (int t = ANY_TYPE; t < TYPE_COUNT; t++) {
+        unsigned long first, last;
+
+        if (t == ANY_TYPE ? query.types != 0
+                          : not typeAllowed(query.types, t))
+            continue;
+
+        const vector<uint32_t> &run = sortedOrder(index, range.column, t);
+        sortedRun(index, columns, range, t, first, last);
+
+        for (unsigned long i = first; i < last; i++) {
+            if (not rowMatches(index, columns, 0, plan.ranges,
+                               plan.rangeCount, run[i]))
+                continue;
+            if (rows != NULL)
+                rows->push_back(run[i]);
+            matches++;
+        }
+    }
+
+    return matches;
+}
+
+/*
+ *  typeAllowed()
+ *
+ *  Parameters: types allowed (one bit per type chart index), type
+ *  Does:       Checks the type's bit.
+ *  Returns:    True if the type is allowed
+ */
+bool typeAllowed(uint32_t types, int type)
+{
+    return types & ((uint32_t)1 << type);
+}
+
+/*
+ *  sortedOrder()
+ *
+ *  Parameters: query index, column, type (ANY_TYPE for every row)
+ *  Does:       Picks the column's rows sorted overall, or grouped by type
+ *              (the type's rows are then typeStart[type] up to
+ *              typeStart[type + 1]).
+ *  Returns:    The sorted row IDs
+ */
+const vector<uint32_t> &sortedOrder(const DexIndex &index, int column,
+                                    int type)
+{
+    return (type == ANY_TYPE) ? index.sorted[column]
+                              : index.typeSorted[column];
+}
+
+/*
+ *  runRows()
+ *
+ *  Parameters: query index, Pokédex columns, types allowed, column range
+ *  Does:       Sizes the range's sorted run within each allowed type.
+ *  Returns:    Number of rows of the allowed types in range
+ */
+unsigned long runRows(const DexIndex &index, const DexColumns &columns,
+                      uint32_t types, const ColumnRange &range)
+{
+    unsigned long rows = 0;
+
+    for (int t = 0; t < TYPE_COUNT; t++) {
+        unsigned long first, last;
+
+        if (not typeAllowed(types, t))
+            continue;
+
+        sortedRun(index, columns, range, t, first, last);
+        rows += last - first;
+    }
+
+    return rows;
+}
+
+/*
+ *  columnValue()
+ *
+ *  Parameters: query index, Pokédex columns, column, row
+ *  Does:       Reads one raw column value.
+ *  Returns:    Base stat (units of 1/STAT_SCALE) or evolution key
+ */
+int columnValue(const DexIndex &index, const DexColumns &columns,
+                int column, uint32_t row)
+{
+    switch (column) {
+        case COL_HP:      return columns.HP[row];
+        case COL_ATTACK:  return columns.attack[row];
+        case COL_DEFENSE: return columns.defense[row];
+        case COL_SPEED:   return columns.speed[row];
+        default:          return index.evolKey[row];
+    }
+}
+
+/*
+ *  minBase()
+ *
+ *  Parameters: stat as stats prints it, level
+ *  Does:       Inverts roundStat(base * level): finds the smallest base
+ *              stat that prints as at least value at this level.
+ *  Returns:    Smallest such base stat, in units of 1/STAT_SCALE
+ */
+int minBase(int value, int level)
+{
+    long scaled = (long)value * STAT_SCALE - STAT_SCALE / 2;
+
+    if (scaled <= 0)
+        return 0;
+    if (scaled > (long)STAT_MAX * level)
+        return STAT_MAX + 1;
+
+    return (scaled + level - 1) / level;
+}
+
+/*
+ *  toRange()
+ *
+ *  Parameters: filter, level stats are compared at
+ *  Does:       Converts a comparison on printed stats (or evolution level)
+ *              into an inclusive range of raw column values. != becomes the
+ *              negation of =. The range may be empty (low > high).
+ *  Returns:    The filter's column range
+ */
+ColumnRange toRange(const StatFilter &filter, int level)
+{
+    ColumnRange range;
+    int value = filter.value;
+    int top = (filter.column == COL_EVOL) ? NEVER_EVOLVES : STAT_MAX;
+    int atLeast, above;
+
+    if (filter.column == COL_EVOL) {
+        atLeast = max(value, 0);
+        above = max(value + 1, 0);
+    } else {
+        atLeast = minBase(value, level);
+        above = minBase(value + 1, level);
+    }
+
+    range.column = filter.column;
+    range.negated = (filter.op == OP_NE);
+
+    switch (filter.op) {
+        case OP_EQ:
+        case OP_NE: range.low = atLeast; range.high = above - 1; break;
+        case OP_LT: range.low = 0;       range.high = atLeast - 1; break;
+        case OP_LE: range.low = 0;       range.high = above - 1; break;
+        case OP_GT: range.low = above;   range.high = top; break;
+        default:    range.low = atLeast; range.high = top; break;
+    }
+    range.high = min(range.high, top);
+
+    return range;
+}
+
+/*
+ *  sortedRun()
+ *
+ *  Parameters: query index, Pokédex columns, column range, type (ANY_TYPE
+ *              for every row), first and last (exclusive) positions to
+ *              populate
+ *  Does:       Binary searches the range's sorted column, or the type's
+ *              group of it, for the run of rows whose values are in range.
+ *              Positions are into sortedOrder() for the type.
+ *  Returns:    NA
+ */
+void sortedRun(const DexIndex &index, const DexColumns &columns,
+               const ColumnRange &range, int type, unsigned long &first,
+               unsigned long &last)
+{
+    const vector<uint32_t> &order = sortedOrder(index, range.column, type);
+    auto begin = order.begin();
+    auto end = order.end();
+
+    if (type != ANY_TYPE) {
+        begin = order.begin() + index.typeStart[type];
+        end = order.begin() + index.typeStart[type + 1];
+    }
+
+    first = lower_bound(begin, end, range.low,
+                        [&](uint32_t row, int value) {
+                            return columnValue(index, columns, range.column,
+                                               row) < value;
+                        }) - order.begin();
+    last = upper_bound(begin, end, range.high,
+                       [&](int value, uint32_t row) {
+                           return value < columnValue(index, columns,
+                                                      range.column, row);
+                       }) - order.begin();
+}
+
+/*
+ *  rowMatches()
+ *
+ *  Parameters: query index, Pokédex columns, types allowed (0 for any),
+ *              column ranges and their number, row
+ *  Does:       Checks one row against the type filter and every range.
+ *  Returns:    True if the row matches the query
+ */
+bool rowMatches(const DexIndex &index, const DexColumns &columns,
+                uint32_t types, const ColumnRange ranges[], int rangeCount,
+                uint32_t row)
+{
+    if (types != 0 and not (types & ((uint32_t)1 << columns.type[row])))
+        return false;
+
+    for (int i = 0; i < rangeCount; i++) {
+        int value = columnValue(index, columns, ranges[i].column, row);
+        bool inRange = value >= ranges[i].low and value <= ranges[i].high;
+
+        if (inRange == ranges[i].negated)
+            return false;
+    }
+
+    return true;
+}
+
+/*
+ *  blockMatches()
+ *
+ *  Parameters: query index, Pokédex columns, query plan, block of 64 rows
+ *  Does:       Evaluates the whole query over one block: ORs the allowed
+ *              types' bitmaps, then ANDs in each range's block mask,
+ *              stopping once no row is left.
+ *  Returns:    Bitmap of the block's matching rows
+ */
+uint64_t blockMatches(const DexIndex &index, const DexColumns &columns,
+                      const QueryPlan &plan, unsigned long block)
+{
+    unsigned long start = block * 64;
+    int count = min((unsigned long)64, index.rows - start);
+    uint64_t mask = (count == 64) ? ~(uint64_t)0
+                                  : ((uint64_t)1 << count) - 1;
+
+    if (plan.typeCount > 0) {
+        uint64_t typed = 0;
+        for (int t = 0; t < plan.typeCount; t++)
+            typed |= plan.typeBits[t][block];
+        mask &= typed;
+    }
+
+    for (int i = 0; i < plan.rangeCount and mask != 0; i++) {
+        const ColumnRange &range = plan.ranges[i];
+        uint64_t hits;
+
+        switch (range.column) {
+            case COL_HP:
+                hits = blockMask(&columns.HP[start], range.low, range.high,
+                                 count);
+                break;
+            case COL_ATTACK:
+                hits = blockMask(&columns.attack[start], range.low,
+                                 range.high, count);
+                break;
+            case COL_DEFENSE:
+                hits = blockMask(&columns.defense[start], range.low,
+                                 range.high, count);
+                break;
+            case COL_SPEED:
+                hits = blockMask(&columns.speed[start], range.low,
+                                 range.high, count);
+                break;
+            default:
+                hits = blockMask(&index.evolKey[start], range.low,
+                                 range.high, count);
+                break;
+        }
+
+        mask &= range.negated ? ~hits : hits;
+    }
+
+    return mask;
+}
+
+/*
+ *  scanBlocks()
+ *
+ *  Parameters: query index, Pokédex columns, query plan
+ *  Does:       Evaluates the whole query 64 rows at a time (see
+ *              blockMatches()).
+ *  Returns:    Number of matching rows
+ */
+unsigned long scanBlocks(const DexIndex &index, const DexColumns &columns,
+                         const QueryPlan &plan)
+{
+    unsigned long blocks = (index.rows + 63) / 64;
+    unsigned long matches = 0;
+
+    for (unsigned long b = 0; b < blocks; b++)
+        matches += __builtin_popcountll(blockMatches(index, columns, plan,
+                                                     b));
+
+    return matches;
+}
+
+/*
+ *  parseNumber()
+ *
+ *  Parameters: text, number to populate
+ *  Does:       Parses the whole text as a decimal integer.
+ *  Returns:    True if it is one, otherwise false
+ */
+bool parseNumber(const string &text, int &value)
+{
+    char *end;
+    long parsed = strtol(text.c_str(), &end, 10);
+
+    if (text.empty() or *end != '\0' or parsed < -1000000
+        or parsed > 1000000)
+        return false;
+
+    value = parsed;
+    return true;
+}
+
+/*
+ *  parseColumn()
+ *
+ *  Parameters: column name
+ *  Does:       Looks up a queryable column by name.
+ *  Returns:    The column, or -1 if there is none by that name
+ */
+int parseColumn(const string &name)
+{
+    static const char *names[] = {"hp", "attack", "defense", "speed",
+                                  "evol"};
+
+    for (int i = 0; i < DEX_COLUMNS; i++) {
+        if (name == names[i])
+            return i;
+    }
+
+    return -1;
+}
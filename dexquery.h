@@ -0,0 +1,86 @@
+/*
+ *      dexquery.h
+ *
+ *      Purpose: Filtered, sorted queries over the columnar Pokédex, such as
+ *               "fire or water species with speed over 80 at level 40 that
+ *               don't evolve before 36, fastest first". Keeps a bitmap of
+ *               rows per type and the rows sorted by each stat column, both
+ *               overall and within each type, so a query touches only the
+ *               rows its most selective filter allows among its types, or
+ *               scans the columns 64 rows at a time.
+ *
+ *      Last modified: October 19, 2026
+ */
+
+#ifndef DEXQUERY_H
+#define DEXQUERY_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "compactdex.h"
+
+/* Queryable columns. Stats are compared as stats prints them at the query's
+ * level; evolution levels are compared as-is, with species that never
+ * evolve treated as evolving at NEVER_EVOLVES. */
+enum DexColumn { COL_HP, COL_ATTACK, COL_DEFENSE, COL_SPEED, COL_EVOL,
+                 DEX_COLUMNS };
+
+enum CompareOp { OP_EQ, OP_NE, OP_LT, OP_LE, OP_GT, OP_GE };
+
+const int NEVER_EVOLVES = 255;
+const int DEFAULT_QUERY_LIMIT = 20;
+const int MAX_FILTERS = 16;
+
+/*
+ * DexIndex
+ *
+ * Query index over DexColumns: each row's evolution level with "never"
+ * mapped to NEVER_EVOLVES, one bitmap of rows (64 per word), one row count
+ * and the start of its group (typeStart[TYPE_COUNT] is the row count) per
+ * type, and every column's row IDs sorted by value (ties in row order),
+ * both overall and grouped by type.
+ */
+struct DexIndex {
+    unsigned long rows;
+    std::vector<uint8_t> evolKey;
+    std::vector< std::vector<uint64_t> > typeBits;
+    std::vector<unsigned long> typeRows;
+    std::vector<unsigned long> typeStart;
+    std::vector<uint32_t> sorted[DEX_COLUMNS];
+    std::vector<uint32_t> typeSorted[DEX_COLUMNS];
+};
+
+/*
+ * StatFilter, DexQuery
+ *
+ * A parsed query: the types allowed (one bit per type chart index, 0 for
+ * any), comparisons on columns, the level stats are compared at, the
+ * column to sort by (-1 for Pokédex order) and its direction, and the most
+ * rows to return. A query has at most MAX_FILTERS comparisons.
+ */
+struct StatFilter {
+    int column;
+    CompareOp op;
+    int value;
+};
+
+struct DexQuery {
+    uint32_t types;
+    std::vector<StatFilter> filters;
+    int level;
+    int sortColumn;
+    bool descending;
+    int limit;
+};
+
+void buildDexIndex(DexIndex &index, const DexColumns &columns);
+bool parseQuery(const std::vector<std::string> &terms, DexQuery &query,
+                std::string &error);
+void runQuery(const DexIndex &index, const DexColumns &columns,
+              const DexQuery &query, std::vector<uint32_t> &rows);
+unsigned long countQuery(const DexIndex &index, const DexColumns &columns,
+                         const DexQuery &query);
+
+#endif
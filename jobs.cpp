@@ -0,0 +1,622 @@
+/*
+ *      jobs.cpp
+ *
+ *      Purpose: Runs a long catch-rate sweep (every Pokédex species at every
+ *               level, against spawns on every given route) as a sharded,
+ *               checkpointed job across local worker processes. The sweep
+ *               is split into deterministic shards; each finished shard is
+ *               written to its own checksummed file, so a killed job resumes
+ *               from the shards already on disk. Workers are forked after
+ *               the Pokédex and routes are packed into one shared memory
+ *               mapping, so no worker re-reads them.
+ *
+ *      Last modified: October 19, 2026
+ */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+#include "pokesim.h"
+
+using namespace std;
+
+const int MAX_LEVEL = 100;
+const int MAX_SLOTS = 64;
+const unsigned long SHARD_ITEMS = 1000;
+const unsigned JOB_SEED = 20200601;
+
+const char SHARD_MAGIC[8] = {'P', 'K', 'M', 'S', 'H', 'A', 'R', 'D'};
+
+/*
+ * SharedRoute
+ *
+ * A route as packed into shared memory: its level range and spawn slots,
+ * each a compact record with the slot's level 1 stats.
+ */
+struct SharedRoute {
+    Range range;
+    int slots;
+    MonRecord mons[MAX_SLOTS];
+};
+
+/*
+ * SharedJob
+ *
+ * Header of the shared mapping: counts, the next pending shard to hand
+ * out (shared by every worker), and the offsets of the routes and the
+ * Pokédex records that follow it.
+ */
+struct SharedJob {
+    unsigned long species;
+    int routes;
+    int encounters;
+    int nextShard;
+    size_t routeOffset;
+    size_t dexOffset;
+    size_t size;
+};
+
+/*
+ * ShardHeader
+ *
+ * Leading record of a shard file. A shard is only reused if its magic,
+ * job fingerprint, shard number and item count match and the checksum of
+ * its header and catch counts is right.
+ */
+struct ShardHeader {
+    char magic[8];
+    unsigned long long fingerprint;
+    unsigned long shard;
+    unsigned long first;
+    unsigned long count;
+    unsigned long long checksum;
+};
+
+SharedJob *shareJob(const SimContext &dex, const vector<SimContext> &routes,
+                    int encounters, string &error);
+const SharedRoute *sharedRoute(const SharedJob *job, int route);
+const MonRecord *sharedDex(const SharedJob *job);
+unsigned long long jobFingerprint(const SharedJob *job,
+                                  const vector< vector<int> > &typeChart);
+unsigned long long checksum(const void *data, size_t size,
+                            unsigned long long hash);
+void runWorker(SharedJob *job, const vector<unsigned long> &pending,
+               unsigned long items, unsigned long long fingerprint,
+               string dir);
+void runShard(const SharedJob *job, SimContext &ctx, unsigned long shard,
+              unsigned long items, vector<uint16_t> &catches);
+Pokemon recordPokemon(const MonRecord &record, int level);
+string shardFile(string dir, unsigned long shard);
+bool writeShard(string dir, unsigned long shard, unsigned long first,
+                unsigned long long fingerprint,
+                const vector<uint16_t> &catches);
+bool readShard(string dir, unsigned long shard, unsigned long items,
+               unsigned long long fingerprint, vector<uint16_t> &catches);
+bool mergeShards(const SimContext &dex, const vector<string> &routeNames,
+                 const SharedJob *job, unsigned long shards,
+                 unsigned long items, unsigned long long fingerprint,
+                 string dir);
+
+int main(int argc, char* argv[])
+{
+    if (argc < 6) {
+        cout << "Usage: ./jobs [pokedex] [output dir] [workers] "
+             << "[encounters] [route]..." << endl;
+        return 1;
+    }
+
+    SimContext dex;
+    string error;
+    string dir = argv[2];
+    int workers = atoi(argv[3]);
+    int encounters = atoi(argv[4]);
+    int count = argc - 5;
+
+    if (workers < 1 or encounters < 1 or encounters > 65535) {
+        cerr << "Workers must be at least 1 and encounters 1 - 65535."
+             << endl;
+        return 1;
+    }
+
+    if (mkdir(dir.c_str(), 0755) != 0 and errno != EEXIST) {
+        cerr << dir << ": cannot create output directory." << endl;
+        return 1;
+    }
+
+    initContext(dex, 0);
+    if (not populateDex(dex, argv[1], error)) {
+        cerr << argv[1] << ": " << error << "." << endl;
+        return 1;
+    }
+
+    vector<SimContext> routes(count);
+    vector<string> routeNames;
+    for (int i = 0; i < count; i++) {
+        initContext(routes[i], 0);
+        if (not populateRoute(routes[i], argv[i + 5])
+            or routes[i].route.empty()
+            or routes[i].route.size() > (unsigned long)MAX_SLOTS) {
+            cerr << argv[i + 5] << ": cannot read route." << endl;
+            return 1;
+        }
+        routeNames.push_back(argv[i + 5]);
+    }
+
+    SharedJob *job = shareJob(dex, routes, encounters, error);
+    if (job == NULL) {
+        cerr << "Cannot share the job: " << error << "." << endl;
+        return 1;
+    }
+
+    unsigned long items = (unsigned long)count * job->species * MAX_LEVEL;
+    unsigned long shards = (items + SHARD_ITEMS - 1) / SHARD_ITEMS;
+    unsigned long long fingerprint = jobFingerprint(job, dex.typeChart);
+
+    // Resumes: only shards without a valid file on disk are run again
+    vector<unsigned long> pending;
+    vector<uint16_t> catches;
+    for (unsigned long shard = 0; shard < shards; shard++) {
+        if (not readShard(dir, shard, items, fingerprint, catches))
+            pending.push_back(shard);
+    }
+
+    // No more workers than shards to run
+    if ((unsigned long)workers > pending.size())
+        workers = pending.size();
+
+    cout << shards - pending.size() << " of " << shards
+         << " shards already complete; running " << pending.size()
+         << " on " << workers << " worker(s)." << endl;
+
+    vector<pid_t> children;
+    for (int w = 0; w < workers; w++) {
+        pid_t pid = fork();
+        if (pid == 0) {
+            runWorker(job, pending, items, fingerprint, dir);
+            _exit(0);
+        }
+        if (pid == -1) {
+            cerr << "Cannot fork worker " << w + 1 << ": " << strerror(errno)
+                 << "." << endl;
+            break;
+        }
+        children.push_back(pid);
+    }
+
+    // Workers already forked claim every shard; with none, run them here
+    if (workers > 0 and children.empty())
+        runWorker(job, pending, items, fingerprint, dir);
+
+    bool failed = false;
+    for (unsigned long i = 0; i < children.size(); i++) {
+        int status;
+        waitpid(children[i], &status, 0);
+        if (not WIFEXITED(status) or WEXITSTATUS(status) != 0)
+            failed = true;
+    }
+
+    if (failed)
+        cerr << "A worker failed; rerun to resume." << endl;
+
+    bool merged = mergeShards(dex, routeNames, job, shards, items,
+                              fingerprint, dir);
+    munmap(job, job->size);
+
+    return merged ? 0 : 1;
+}
+
+/*
+ *  shareJob()
+ *
+ *  Parameters: context with loaded Pokédex, contexts with loaded routes,
+ *              encounters per species, level and route, error message to
+ *              populate
+ *  Does:       Packs the routes and the Pokédex (as level 1 compact
+ *              records) into an anonymous shared mapping that forked
+ *              workers read in place. Route stats are narrowed with the
+ *              same checks as the Pokédex columns.
+ *  Returns:    The mapping's header, or NULL with the error set if it
+ *              cannot be mapped or a route stat does not fit its field
+ */
+SharedJob *shareJob(const SimContext &dex, const vector<SimContext> &routes,
+                    int encounters, string &error)
+{
+    unsigned long species = dex.pokedex.size();
+    size_t routeOffset = sizeof(SharedJob);
+    size_t dexOffset = routeOffset + routes.size() * sizeof(SharedRoute);
+    size_t size = dexOffset + species * sizeof(MonRecord);
+
+    void *data = mmap(NULL, size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (data == MAP_FAILED) {
+        error = "cannot map shared memory";
+        return NULL;
+    }
+
+    memset(data, 0, size);
+
+    SharedJob *job = (SharedJob *)data;
+    job->species = species;
+    job->routes = routes.size();
+    job->encounters = encounters;
+    job->nextShard = 0;
+    job->routeOffset = routeOffset;
+    job->dexOffset = dexOffset;
+    job->size = size;
+
+    try {
+        for (unsigned long r = 0; r < routes.size(); r++) {
+            SharedRoute *route = (SharedRoute *)((char *)data + routeOffset)
+                                 + r;
+
+            route->range = routes[r].range;
+            route->slots = routes[r].route.size();
+            for (int s = 0; s < route->slots; s++) {
+                const Pokemon &mon = routes[r].route[s];
+                MonRecord &record = route->mons[s];
+
+                record.HP = narrowStat(mon.HP, mon.name, "HP");
+                record.attack = narrowStat(mon.attack, mon.name, "attack");
+                record.defense = narrowStat(mon.defense, mon.name,
+                                            "defense");
+                record.speed = narrowStat(mon.speed, mon.name, "speed");
+                record.type = typeIndex(mon.type);
+                record.level = 1;
+            }
+        }
+    } catch (const overflow_error &e) {
+        munmap(data, size);
+        error = e.what();
+        return NULL;
+    }
+
+    MonRecord *records = (MonRecord *)((char *)data + dexOffset);
+    for (unsigned long i = 0; i < species; i++)
+        records[i] = makeRecord(dex.columns, i, 1);
+
+    return job;
+}
+
+/*
+ *  sharedRoute(), sharedDex()
+ *
+ *  Parameters: shared job, route number
+ *  Does:       Locates a route, or the Pokédex records, in the mapping.
+ *  Returns:    Pointer into the shared mapping
+ */
+const SharedRoute *sharedRoute(const SharedJob *job, int route)
+{
+    return (const SharedRoute *)((const char *)job + job->routeOffset)
+           + route;
+}
+
+const MonRecord *sharedDex(const SharedJob *job)
+{
+    return (const MonRecord *)((const char *)job + job->dexOffset);
+}
+
+/*
+ *  jobFingerprint()
+ *
+ *  Parameters: shared job, type chart
+ *  Does:       Hashes everything a shard's results depend on: the packed
+ *              routes and Pokédex, encounters, seed, shard size, and the
+ *              ruleset, so shards from a different job are never reused.
+ *  Returns:    Job fingerprint
+ */
+unsigned long long jobFingerprint(const SharedJob *job,
+                                  const vector< vector<int> > &typeChart)
+{
+    unsigned long long hash = 14695981039346656037ull;
+    unsigned params[3] = {rulesetVersion(typeChart), JOB_SEED,
+                          (unsigned)SHARD_ITEMS};
+
+    hash = checksum(params, sizeof(params), hash);
+    hash = checksum(&job->encounters, sizeof(job->encounters), hash);
+    hash = checksum(sharedRoute(job, 0), job->routes * sizeof(SharedRoute),
+                    hash);
+    hash = checksum(sharedDex(job), job->species * sizeof(MonRecord), hash);
+
+    return hash;
+}
+
+/*
+ *  checksum()
+ *
+ *  Parameters: bytes to hash, their size, running hash
+ *  Does:       Continues a 64-bit FNV-1a hash over the bytes.
+ *  Returns:    Updated hash
+ */
+unsigned long long checksum(const void *data, size_t size,
+                            unsigned long long hash)
+{
+    const unsigned char *bytes = (const unsigned char *)data;
+
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+
+    return hash;
+}
+
+/*
+ *  runWorker()
+ *
+ *  Parameters: shared job, pending shards, total items, job fingerprint,
+ *              output directory
+ *  Does:       In a forked worker (or the parent, if no worker could be
+ *              forked), claims pending shards one at a time from the
+ *              shared counter, runs them, and writes each to its file.
+ *              The worker's context holds only its RNG and the type chart;
+ *              Pokémon are read from the shared mapping.
+ *  Returns:    NA
+ */
+void runWorker(SharedJob *job, const vector<unsigned long> &pending,
+               unsigned long items, unsigned long long fingerprint,
+               string dir)
+{
+    SimContext ctx;
+    vector<uint16_t> catches;
+
+    initContext(ctx, 0);
+
+    while (true) {
+        int next = __sync_fetch_and_add(&job->nextShard, 1);
+        if (next >= (int)pending.size())
+            break;
+
+        unsigned long shard = pending[next];
+        runShard(job, ctx, shard, items, catches);
+
+        if (not writeShard(dir, shard, shard * SHARD_ITEMS, fingerprint,
+                           catches)) {
+            cerr << shardFile(dir, shard) + ": cannot write.\n";
+            _exit(1);
+        }
+
+        ostringstream done;
+        done << "Shard " << shard << " done (" << getpid() << ")\n";
+        cerr << done.str();
+    }
+}
+
+/*
+ *  runShard()
+ *
+ *  Parameters: shared job, worker's context, shard number, total items,
+ *              catch counts to populate
+ *  Does:       Runs the shard's items. Item numbers enumerate (route,
+ *              species, level); for each, the species at that level battles
+ *              the job's number of spawns from the route. Every item seeds
+ *              the RNG from its own number, so results do not depend on
+ *              which worker runs the shard or in what order.
+ *  Returns:    NA
+ */
+void runShard(const SharedJob *job, SimContext &ctx, unsigned long shard,
+              unsigned long items, vector<uint16_t> &catches)
+{
+    unsigned long first = shard * SHARD_ITEMS;
+    unsigned long last = min(items, first + SHARD_ITEMS);
+    const MonRecord *dex = sharedDex(job);
+
+    int loaded = -1;
+
+    catches.assign(last - first, 0);
+
+    for (unsigned long item = first; item < last; item++) {
+        int level = item % MAX_LEVEL + 1;
+        unsigned long species = item / MAX_LEVEL % job->species;
+        int route = item / MAX_LEVEL / job->species;
+        const SharedRoute *spawns = sharedRoute(job, route);
+
+        seed_seq seed = {JOB_SEED, (unsigned)item, (unsigned)(item >> 32)};
+        ctx.rng.seed(seed);
+
+        if (route != loaded) {
+            ctx.range = spawns->range;
+            ctx.route.clear();
+            for (int s = 0; s < spawns->slots; s++)
+                ctx.route.push_back(recordPokemon(spawns->mons[s], 1));
+            loaded = route;
+        }
+
+        Pokemon trainer = recordPokemon(dex[species], level);
+
+        for (int e = 0; e < job->encounters; e++) {
+            Pokemon encounter;
+            spawn(ctx, encounter);
+            if (battle(ctx, trainer, encounter, NULL).firstWon)
+                catches[item - first]++;
+        }
+    }
+}
+
+/*
+ *  recordPokemon()
+ *
+ *  Parameters: compact record with level 1 stats, level
+ *  Does:       Builds the Pokémon battle() and spawn() need from a shared
+ *              record, without a name (expandRecord() would need the
+ *              Pokédex's string table).
+ *  Returns:    The unnamed Pokémon at the given level
+ */
+Pokemon recordPokemon(const MonRecord &record, int level)
+{
+    Pokemon mon;
+
+    mon.HP       = record.HP * level;
+    mon.attack   = record.attack * level;
+    mon.defense  = record.defense * level;
+    mon.speed    = record.speed * level;
+    mon.type     = typeName(record.type);
+    mon.nextEvol = record.nextEvol;
+
+    return mon;
+}
+
+/*
+ *  shardFile()
+ *
+ *  Parameters: output directory, shard number
+ *  Does:       Names a shard's file.
+ *  Returns:    Path of the shard file
+ */
+string shardFile(string dir, unsigned long shard)
+{
+    char name[32];
+
+    snprintf(name, sizeof(name), "shard-%05lu.dat", shard);
+
+    return dir + "/" + name;
+}
+
+/*
+ *  writeShard()
+ *
+ *  Parameters: output directory, shard number, its first item, job
+ *              fingerprint, catch counts
+ *  Does:       Writes the shard to a temporary file, syncs it, and renames
+ *              it into place, so a shard file is either whole or absent.
+ *  Returns:    True if the shard was written, otherwise false
+ */
+bool writeShard(string dir, unsigned long shard, unsigned long first,
+                unsigned long long fingerprint,
+                const vector<uint16_t> &catches)
+{
+    ShardHeader header;
+    size_t size = catches.size() * sizeof(uint16_t);
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SHARD_MAGIC, sizeof(SHARD_MAGIC));
+    header.fingerprint = fingerprint;
+    header.shard = shard;
+    header.first = first;
+    header.count = catches.size();
+    header.checksum = checksum(catches.data(), size,
+                               checksum(&header, sizeof(header), 0));
+
+    string file = shardFile(dir, shard);
+    string temp = file + ".tmp";
+
+    int fd = open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return false;
+
+    bool written = write(fd, &header, sizeof(header)) == sizeof(header)
+                   and write(fd, catches.data(), size) == (ssize_t)size
+                   and fsync(fd) == 0;
+    close(fd);
+
+    return written and rename(temp.c_str(), file.c_str()) == 0;
+}
+
+/*
+ *  readShard()
+ *
+ *  Parameters: output directory, shard number, total items, job
+ *              fingerprint, catch counts to populate
+ *  Does:       Reads a shard file and checks that it belongs to this job
+ *              and shard, holds the expected number of items, and matches
+ *              its checksum. The checksum is computed with its own field
+ *              zeroed, as when written.
+ *  Returns:    True if the shard is complete and valid, otherwise false
+ */
+bool readShard(string dir, unsigned long shard, unsigned long items,
+               unsigned long long fingerprint, vector<uint16_t> &catches)
+{
+    ifstream input(shardFile(dir, shard).c_str(), ios::binary);
+    ShardHeader header;
+
+    if (not input.read((char *)&header, sizeof(header)))
+        return false;
+
+    unsigned long first = shard * SHARD_ITEMS;
+    unsigned long count = min(items, first + SHARD_ITEMS) - first;
+
+    if (memcmp(header.magic, SHARD_MAGIC, sizeof(SHARD_MAGIC)) != 0
+        or header.fingerprint != fingerprint or header.shard != shard
+        or header.first != first or header.count != count)
+        return false;
+
+    catches.resize(count);
+    if (not input.read((char *)catches.data(), count * sizeof(uint16_t)))
+        return false;
+
+    unsigned long long expected = header.checksum;
+    header.checksum = 0;
+
+    return checksum(catches.data(), count * sizeof(uint16_t),
+                    checksum(&header, sizeof(header), 0)) == expected;
+}
+
+/*
+ *  mergeShards()
+ *
+ *  Parameters: context with loaded Pokédex, route files, shared job, number
+ *              of shards, total items, job fingerprint, output directory
+ *  Does:       Verifies every shard and, if all are complete, writes
+ *              results.tsv: route, species, level, encounters, catches,
+ *              and catch rate per line.
+ *  Returns:    True if every shard was complete and results were written
+ */
+bool mergeShards(const SimContext &dex, const vector<string> &routeNames,
+                 const SharedJob *job, unsigned long shards,
+                 unsigned long items, unsigned long long fingerprint,
+                 string dir)
+{
+    vector<uint16_t> catches;
+    unsigned long missing = 0;
+
+    for (unsigned long shard = 0; shard < shards; shard++) {
+        if (not readShard(dir, shard, items, fingerprint, catches))
+            missing++;
+    }
+
+    if (missing > 0) {
+        cerr << missing << " of " << shards
+             << " shards incomplete; rerun to resume." << endl;
+        return false;
+    }
+
+    ofstream output((dir + "/results.tsv").c_str());
+    if (not output.is_open()) {
+        cerr << dir << ": cannot write results.tsv." << endl;
+        return false;
+    }
+
+    output << "route\tspecies\tlevel\tencounters\tcatches\trate\n";
+    for (unsigned long shard = 0; shard < shards; shard++) {
+        readShard(dir, shard, items, fingerprint, catches);
+
+        for (unsigned long i = 0; i < catches.size(); i++) {
+            unsigned long item = shard * SHARD_ITEMS + i;
+            int level = item % MAX_LEVEL + 1;
+            unsigned long species = item / MAX_LEVEL % job->species;
+            int route = item / MAX_LEVEL / job->species;
+
+            output << routeNames[route] << "\t"
+                   << dex.pokedex[species].name << "\t" << level << "\t"
+                   << job->encounters << "\t" << catches[i] << "\t"
+                   << (double)catches[i] / job->encounters << "\n";
+        }
+    }
+
+    cout << "Merged " << shards << " shards (" << items << " items) into "
+         << dir << "/results.tsv" << endl;
+
+    return true;
+}
@@ -0,0 +1,960 @@
+/*
+ *      matchup.cpp
+ *
+ *      Purpose: Simulates repeated battles between two Pokémon to estimate
+ *               win probability (to a requested precision), expected turns,
+ *               and remaining HP, and caches those results so the same
+ *               matchup is only simulated once.
+ *               The cache is sharded, evicts least recently used entries,
+ *               and is persisted to a memory-mapped file between runs.
+ *
+ *      Last modified: October 19, 2026
+ */
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "matchup.h"
+#include "arena.h"
+
+using namespace std;
+
+/*
+ * CacheHeader
+ *
+ * Leading record of the cache file. Files with the wrong magic, format or
+ * record size are ignored rather than misread.
+ */
+struct CacheHeader {
+    char magic[8];
+    unsigned format;
+    unsigned recordSize;
+    unsigned long long count;
+};
+
+const char *TYPE_NAMES[TYPE_COUNT] = {"normal", "fighting", "flying",
+                                      "poison", "ground", "rock", "bug",
+                                      "ghost", "steel", "fire", "water",
+                                      "grass", "electric", "psychic", "ice",
+                                      "dragon", "dark", "fairy"};
+
+const char CACHE_MAGIC[8] = {'P', 'K', 'M', 'C', 'A', 'C', 'H', 'E'};
+const unsigned CACHE_FORMAT = 3;
+
+/* Sequential estimation: battles are sampled in batches of BATCH_PAIRS
+ * mirrored pairs, and at least MIN_BATCHES batches are needed to estimate
+ * the variance before stopping. */
+const int BATCH_PAIRS = 4;
+const int MIN_BATCHES = 4;
+const int MAX_SAMPLES = 1000000;
+
+/* Scratch tables start with room for twice a side's hits (a few more for
+ * very short matchups) and double whenever a run of misses needs more. */
+const int EXTRA_ATTACKS = 8;
+
+/*
+ * AttackDraws
+ *
+ * One side's uniform draws after its first, how many have been drawn, the
+ * outcome of each attack (0 miss, 1 regular hit, 2 critical hit), and the
+ * room in both tables.
+ */
+struct AttackDraws {
+    double *draws;
+    int drawn;
+    int *units;
+    int room;
+};
+
+/*
+ * SurvivalTable
+ *
+ * Probability that the defender needs at least n attacks for each n
+ * computed so far, the probability of each hit count short of a knockout
+ * after the last of them, and the room in the table.
+ */
+struct SurvivalTable {
+    double *alive;
+    int computed;
+    double *reach;
+    int room;
+};
+
+CacheShard &shardFor(MatchupCache &cache, const MatchupKey &key);
+void fillSide(MatchupSide &side, const Pokemon &mon, int level);
+size_t hashSide(size_t hash, const MatchupSide &side);
+void initDraws(Arena &arena, AttackDraws &side, int hits);
+int drawAttacks(Arena &arena, AttackDraws &side, int hits, double first,
+                bool mirrored, mt19937 &rng);
+double survival(Arena &arena, SurvivalTable &table, int hits, int attacks);
+double zScore(double confidence);
+double tScore(double z, long freedom);
+double stateProb(const double table[], int atkLeft, int defLeft, int cols);
+double landProb(int attacks, int needed);
+
+/*
+ *  rulesetVersion()
+ *
+ *  Parameters: Pokémon type chart
+ *  Does:       Combines RULESET_VERSION with a hash of every type chart
+ *              entry, so cached results are invalidated whenever either the
+ *              battle rules or the type chart change.
+ *  Returns:    Ruleset version to key cached matchups with
+ */
+unsigned rulesetVersion(const vector< vector<int> > &typeChart)
+{
+    unsigned hash = 2166136261u ^ RULESET_VERSION;
+
+    for (unsigned long i = 0; i < typeChart.size(); i++) {
+        for (unsigned long j = 0; j < typeChart[i].size(); j++) {
+            hash ^= (unsigned)typeChart[i][j];
+            hash *= 16777619u;
+        }
+    }
+
+    return hash;
+}
+
+/*
+ *  makeKey()
+ *
+ *  Parameters: attacking Pokémon (stats already scaled by level) and its
+ *              level, defending Pokémon and its level, ruleset version
+ *  Does:       Builds a zero-padded cache key. Names longer than the key
+ *              allows are truncated.
+ *  Returns:    Populated matchup key
+ */
+MatchupKey makeKey(const Pokemon &attacker, int atkLevel,
+                   const Pokemon &defender, int defLevel, unsigned ruleset)
+{
+    MatchupKey key;
+
+    memset(&key, 0, sizeof(key));
+    fillSide(key.attacker, attacker, atkLevel);
+    fillSide(key.defender, defender, defLevel);
+    key.ruleset = ruleset;
+
+    return key;
+}
+
+/*
+ *  fillSide()
+ *
+ *  Parameters: zeroed side of a key, Pokémon (stats already scaled by
+ *              level), level
+ *  Does:       Copies the Pokémon's name, level, stats and type into the
+ *              key.
+ *  Returns:    NA
+ */
+void fillSide(MatchupSide &side, const Pokemon &mon, int level)
+{
+    strncpy(side.name, mon.name.c_str(), NAME_LEN - 1);
+    side.level = level;
+    side.HP = mon.HP;
+    side.attack = mon.attack;
+    side.defense = mon.defense;
+    side.speed = mon.speed;
+    side.type = typeIndex(mon.type);
+}
+
+/*
+ *  simulateMatchup()
+ *
+ *  Parameters: attacking and defending Pokémon (stats already scaled by
+ *              level), type chart, target half-width of the win
+ *              probability's confidence interval (e.g. 0.005 for ±0.5%),
+ *              confidence level (e.g. 0.99), random number generator
+ *  Does:       Samples battles following the same rules as catch and
+ *              battle, a batch at a time, until the win probability's
+ *              interval is within the target precision or MAX_SAMPLES
+ *              battles have been run. Each side's attacks up to its
+ *              knockout are drawn separately and the battle is decided by
+ *              whose knockout lands first. Three things keep the variance
+ *              down:
+ *                - the win probability is averaged given the attacker's
+ *                  draws, with the defender's side summed exactly by
+ *                  survival(), so only the attacker's luck adds noise
+ *                - every battle is paired with one that replays its draws
+ *                  mirrored (1 - u), which turns misses into crits
+ *                - each side's first draw is stratified over the batch, so
+ *                  every batch sees misses, hits and crits in proportion
+ *              Batches are independent, so the interval is a Student t
+ *              interval over batch means. Lopsided matchups have almost no
+ *              variance left and stop after MIN_BATCHES batches. Battles
+ *              run until a knockout, however long, exactly as
+ *              winProbability() models them; if neither Pokémon can do
+ *              damage, the attacker loses with no turns taken, as in
+ *              battle().
+ *  Returns:    Attacker's win probability with the achieved half-width and
+ *              battles sampled, expected turns, and remaining HP
+ *              distribution
+ */
+MatchupResult simulateMatchup(const Pokemon &attacker, const Pokemon &defender,
+                              const vector< vector<int> > &typeChart,
+                              double precision, double confidence,
+                              mt19937 &rng)
+{
+    MatchupResult result;
+    memset(&result, 0, sizeof(result));
+
+    MatchupClass matchup = classifyMatchup(attacker, defender, typeChart);
+    int defEffect = typeChart[typeIndex(defender.type)]
+                             [typeIndex(attacker.type)];
+    int defDamage = hitDamage(defender.attack, attacker.defense, defEffect);
+    long atkHP = (long)attacker.HP * EFFECT_SCALE;
+    double z = zScore(confidence);
+
+    uniform_real_distribution<double> uniform(0.0, 1.0);
+    int strata[BATCH_PAIRS];
+
+    // Scratch tables come from the thread's arena, released on return
+    Arena &arena = threadArena();
+    ArenaMark mark = arenaMark(arena);
+    AttackDraws atkSide, defSide;
+    SurvivalTable defSurvival;
+
+    initDraws(arena, atkSide, matchup.atkHits);
+    initDraws(arena, defSide, matchup.defHits);
+    defSurvival.room = atkSide.room + 1;
+    defSurvival.alive = arenaArray<double>(arena, defSurvival.room);
+    defSurvival.reach = arenaArray<double>(arena, max(matchup.defHits, 1));
+    defSurvival.computed = 0;
+
+    // Running mean and sum of squared deviations of the batch means
+    long batches = 0;
+    double mean = 0, deviations = 0;
+    long totalTurns = 0;
+
+    while (result.samples < MAX_SAMPLES) {
+        double batchSum = 0;
+
+        for (int i = 0; i < BATCH_PAIRS; i++)
+            strata[i] = i;
+        shuffle(strata, strata + BATCH_PAIRS, rng);
+
+        for (int i = 0; i < BATCH_PAIRS; i++) {
+            double atkFirstDraw = (i + uniform(rng)) / BATCH_PAIRS;
+            double defFirstDraw = (strata[i] + uniform(rng)) / BATCH_PAIRS;
+
+            atkSide.drawn = 0;
+            defSide.drawn = 0;
+
+            for (int mirrored = 0; mirrored < 2; mirrored++) {
+                int atkAttacks = drawAttacks(arena, atkSide, matchup.atkHits,
+                                             atkFirstDraw, mirrored, rng);
+                int defAttacks = drawAttacks(arena, defSide, matchup.defHits,
+                                             defFirstDraw, mirrored, rng);
+
+                // The defender survives to its n-th attack if it needs at
+                // least n attacks; it gets one more attack in when it moves
+                // first
+                int defNeeds = matchup.atkFirst ? atkAttacks : atkAttacks + 1;
+                long atkTurn = LONG_MAX, defTurn = LONG_MAX;
+
+                if (atkAttacks != NO_KO)
+                    atkTurn = matchup.atkFirst ? 2L * atkAttacks - 1
+                                               : 2L * atkAttacks;
+                if (defAttacks != NO_KO)
+                    defTurn = matchup.atkFirst ? 2L * defAttacks
+                                               : 2L * defAttacks - 1;
+
+                if (atkAttacks != NO_KO)
+                    batchSum += survival(arena, defSurvival, matchup.defHits,
+                                         defNeeds);
+
+                int bucket = 0;
+                if (atkTurn < defTurn) {
+                    long taken = 0;
+                    if (matchup.defHits != NO_KO) {
+                        for (int j = 0; j < defNeeds - 1; j++)
+                            taken += defSide.units[j];
+                    }
+
+                    bucket = (atkHP - taken * defDamage) * HP_BUCKETS / atkHP;
+                    if (bucket >= HP_BUCKETS)
+                        bucket = HP_BUCKETS - 1;
+                    totalTurns += atkTurn;
+                } else if (defAttacks != NO_KO) {
+                    totalTurns += defTurn;
+                }
+                result.hpDist[bucket] += 1;
+            }
+        }
+
+        result.samples += 2 * BATCH_PAIRS;
+        batches++;
+
+        double batchMean = batchSum / (2 * BATCH_PAIRS);
+        double delta = batchMean - mean;
+        mean += delta / batches;
+        deviations += delta * (batchMean - mean);
+
+        if (batches >= MIN_BATCHES) {
+            result.halfWidth = tScore(z, batches - 1)
+                               * sqrt(deviations / (batches - 1) / batches);
+            if (result.halfWidth <= precision)
+                break;
+        }
+    }
+
+    result.winProb = mean;
+    result.expTurns = (double)totalTurns / result.samples;
+    for (int i = 0; i < HP_BUCKETS; i++)
+        result.hpDist[i] /= result.samples;
+
+    arenaRelease(arena, mark);
+
+    return result;
+}
+
+/*
+ *  initDraws()
+ *
+ *  Parameters: arena, one side's draws, regular hits it needs for a
+ *              knockout
+ *  Does:       Allocates the side's tables from the arena, with room for
+ *              twice its hits, and marks them empty.
+ *  Returns:    NA
+ */
+void initDraws(Arena &arena, AttackDraws &side, int hits)
+{
+    side.room = 2 * hits + EXTRA_ATTACKS;
+    side.draws = arenaArray<double>(arena, side.room);
+    side.units = arenaArray<int>(arena, side.room);
+    side.drawn = 0;
+}
+
+/*
+ *  drawAttacks()
+ *
+ *  Parameters: arena, one side's draws (extended and grown as needed),
+ *              regular hits it needs for a knockout, first uniform draw,
+ *              whether to mirror the draws, random number generator
+ *  Does:       Turns uniform draws into attacks until they add up to a
+ *              knockout, recording each attack's outcome: a draw below
+ *              P_MISS misses and one in the top P_CRIT is critical.
+ *              Mirrored draws use 1 - u, so a mirrored replay reuses the
+ *              same draws.
+ *  Returns:    Number of attacks needed, or NO_KO if the Pokémon deals no
+ *              damage
+ */
+int drawAttacks(Arena &arena, AttackDraws &side, int hits, double first,
+                bool mirrored, mt19937 &rng)
+{
+    uniform_real_distribution<double> uniform(0.0, 1.0);
+    int landed = 0;
+    int attack = 0;
+
+    if (hits == NO_KO)
+        return NO_KO;
+
+    while (landed < hits) {
+        if (attack == side.room) {
+            side.draws = arenaGrow(arena, side.draws, side.drawn,
+                                   2 * side.room);
+            side.units = arenaGrow(arena, side.units, attack, 2 * side.room);
+            side.room *= 2;
+        }
+
+        if (attack > 0 and side.drawn < attack)
+            side.draws[side.drawn++] = uniform(rng);
+
+        double u = (attack == 0) ? first : side.draws[attack - 1];
+        if (mirrored)
+            u = 1 - u;
+
+        int unit = 1;
+        if (u < P_MISS)
+            unit = 0;
+        else if (u >= 1 - P_CRIT)
+            unit = 2;
+
+        side.units[attack++] = unit;
+        landed += unit;
+    }
+
+    return attack;
+}
+
+/*
+ *  survival()
+ *
+ *  Parameters: arena, the defender's survival table (extended and grown as
+ *              needed), regular hits the defender needs, number of attacks
+ *  Does:       Computes the probability that the defender needs at least
+ *              the given number of attacks to knock out the attacker, i.e.
+ *              that one fewer attacks fall short.
+ *  Returns:    Probability the defender needs at least that many attacks
+ */
+double survival(Arena &arena, SurvivalTable &table, int hits, int attacks)
+{
+    if (hits == NO_KO)
+        return 1.0;
+
+    if (table.computed == 0) {
+        fill(table.reach, table.reach + hits, 0.0);
+        table.reach[0] = 1.0;
+        table.alive[table.computed++] = 1.0;
+        table.alive[table.computed++] = 1.0;
+    }
+
+    if (attacks >= table.room) {
+        int room = max(2 * table.room, attacks + 1);
+        table.alive = arenaGrow(arena, table.alive, table.computed, room);
+        table.room = room;
+    }
+
+    while (table.computed <= attacks) {
+        double alive = 0;
+
+        for (int landed = hits - 1; landed >= 0; landed--) {
+            double prob = P_MISS * table.reach[landed];
+            if (landed >= 1)
+                prob += P_HIT * table.reach[landed - 1];
+            if (landed >= 2)
+                prob += P_CRIT * table.reach[landed - 2];
+
+            table.reach[landed] = prob;
+            alive += prob;
+        }
+        table.alive[table.computed++] = alive;
+    }
+
+    return table.alive[attacks];
+}
+
+/*
+ *  zScore()
+ *
+ *  Parameters: confidence level, between 0 and 1
+ *  Does:       Finds the two-sided normal critical value by bisection.
+ *  Returns:    z such that P(|Z| <= z) is the confidence level
+ */
+double zScore(double confidence)
+{
+    double low = 0, high = 10;
+
+    for (int i = 0; i < 60; i++) {
+        double mid = (low + high) / 2;
+        if (erf(mid / sqrt(2.0)) < confidence)
+            low = mid;
+        else
+            high = mid;
+    }
+
+    return (low + high) / 2;
+}
+
+/*
+ *  hitsToKO()
+ *
+ *  Parameters: defending Pokémon's HP (units of 1/STAT_SCALE), damage of one
+ *              regular hit (units of 1/DAMAGE_SCALE)
+ *  Does:       Counts the regular hits needed to bring HP to 0 or below.
+ *              A critical hit counts as two regular hits.
+ *  Returns:    Number of regular hits needed, or NO_KO if damage is 0
+ */
+int hitsToKO(int HP, int damage)
+{
+    if (damage <= 0)
+        return NO_KO;
+
+    return (HP * EFFECT_SCALE + damage - 1) / damage;
+}
+
+/*
+ *  classifyMatchup()
+ *
+ *  Parameters: attacking and defending Pokémon (stats already scaled by
+ *              level), type chart
+ *  Does:       Reduces a matchup to the hits each side needs for a knockout
+ *              and the turn order.
+ *  Returns:    The matchup's class
+ */
+MatchupClass classifyMatchup(const Pokemon &attacker, const Pokemon &defender,
+                             const vector< vector<int> > &typeChart)
+{
+    MatchupClass matchup;
+
+    int atkEffect = typeChart[typeIndex(attacker.type)]
+                             [typeIndex(defender.type)];
+    int defEffect = typeChart[typeIndex(defender.type)]
+                             [typeIndex(attacker.type)];
+
+    matchup.atkHits = hitsToKO(defender.HP, hitDamage(attacker.attack,
+                                                      defender.defense,
+                                                      atkEffect));
+    matchup.defHits = hitsToKO(attacker.HP, hitDamage(defender.attack,
+                                                      attacker.defense,
+                                                      defEffect));
+    matchup.atkFirst = attacker.speed > defender.speed;
+
+    return matchup;
+}
+
+/*
+ *  classKey()
+ *
+ *  Parameters: matchup class
+ *  Does:       Packs a matchup class into a single hashable value.
+ *  Returns:    Packed class
+ */
+long long classKey(const MatchupClass &matchup)
+{
+    return ((long long)matchup.atkHits << 32)
+           | ((long long)matchup.defHits << 1) | (matchup.atkFirst ? 1 : 0);
+}
+
+/*
+ *  winProbability()
+ *
+ *  Parameters: matchup class
+ *  Does:       Computes the attacker's exact win probability by dynamic
+ *              programming over (hits attacker still needs, hits defender
+ *              still needs, whose turn). A miss passes the turn without
+ *              progress, so each pair of turn states is solved together.
+ *              A Pokémon that deals no damage never wins.
+ *  Returns:    Attacker's probability of winning
+ */
+double winProbability(const MatchupClass &matchup)
+{
+    if (matchup.atkHits == NO_KO)
+        return 0.0;
+    if (matchup.defHits == NO_KO)
+        return 1.0;
+
+    int cols = matchup.defHits + 1;
+    int size = (matchup.atkHits + 1) * cols;
+
+    // Probability the attacker wins from each state, on either side's turn
+    Arena &arena = threadArena();
+    ArenaMark mark = arenaMark(arena);
+    double *atkTurn = arenaArray<double>(arena, size);
+    double *defTurn = arenaArray<double>(arena, size);
+
+    for (int a = 1; a <= matchup.atkHits; a++) {
+        for (int d = 1; d <= matchup.defHits; d++) {
+            double atkMoves = P_HIT  * stateProb(defTurn, a - 1, d, cols)
+                            + P_CRIT * stateProb(defTurn, a - 2, d, cols);
+            double defMoves = P_HIT  * stateProb(atkTurn, a, d - 1, cols)
+                            + P_CRIT * stateProb(atkTurn, a, d - 2, cols);
+
+            atkTurn[a * cols + d] = (atkMoves + P_MISS * defMoves)
+                                    / (1 - P_MISS * P_MISS);
+            defTurn[a * cols + d] = P_MISS * atkTurn[a * cols + d] + defMoves;
+        }
+    }
+
+    double winProb = (matchup.atkFirst == true) ? atkTurn[size - 1]
+                                                : defTurn[size - 1];
+    arenaRelease(arena, mark);
+
+    return winProb;
+}
+
+/*
+ *  winBounds()
+ *
+ *  Parameters: matchup class, lower and upper bounds to populate
+ *  Does:       Bounds the attacker's win probability without solving the
+ *              matchup, from the fewest attacks each side could need (every
+ *              hit critical). Before the attacker's fastest knockout the
+ *              defender gets a fixed number of attacks, and the attacker
+ *              loses if enough of those land; before the defender's fastest
+ *              knockout the attacker gets a fixed number, and wins if enough
+ *              of those land.
+ *  Returns:    NA
+ */
+void winBounds(const MatchupClass &matchup, double &low, double &high)
+{
+    if (matchup.atkHits == NO_KO) {
+        low = high = 0.0;
+        return;
+    }
+    if (matchup.defHits == NO_KO) {
+        low = high = 1.0;
+        return;
+    }
+
+    int atkFewest = (matchup.atkHits + 1) / 2;
+    int defFewest = (matchup.defHits + 1) / 2;
+    int defAttacks = matchup.atkFirst ? atkFewest - 1 : atkFewest;
+    int atkAttacks = matchup.atkFirst ? defFewest : defFewest - 1;
+
+    high = 1.0 - landProb(defAttacks, matchup.defHits);
+    low = landProb(atkAttacks, matchup.atkHits);
+}
+
+/*
+ *  initCache()
+ *
+ *  Parameters: cache, maximum number of entries held across all shards
+ *  Does:       Empties every shard and sets the cache's capacity.
+ *  Returns:    NA
+ */
+void initCache(MatchupCache &cache, size_t capacity)
+{
+    cache.capacity = capacity;
+
+    for (int i = 0; i < CACHE_SHARDS; i++) {
+        lock_guard<mutex> guard(cache.shards[i].lock);
+        cache.shards[i].lru.clear();
+        cache.shards[i].index.clear();
+    }
+}
+
+/*
+ *  lookupMatchup()
+ *
+ *  Parameters: cache, matchup key, result to populate
+ *  Does:       Looks up the matchup and, if found, marks it most recently
+ *              used and copies it into result.
+ *  Returns:    True if the matchup was cached, otherwise false
+ */
+bool lookupMatchup(MatchupCache &cache, const MatchupKey &key,
+                   MatchupResult &result)
+{
+    CacheShard &shard = shardFor(cache, key);
+    lock_guard<mutex> guard(shard.lock);
+
+    auto found = shard.index.find(key);
+    if (found == shard.index.end())
+        return false;
+
+    shard.lru.splice(shard.lru.begin(), shard.lru, found->second);
+    result = found->second->result;
+
+    return true;
+}
+
+/*
+ *  storeMatchup()
+ *
+ *  Parameters: cache, matchup key, simulated result
+ *  Does:       Inserts or replaces the matchup as most recently used, then
+ *              evicts the shard's least recently used entries over capacity.
+ *  Returns:    NA
+ */
+void storeMatchup(MatchupCache &cache, const MatchupKey &key,
+                  const MatchupResult &result)
+{
+    CacheShard &shard = shardFor(cache, key);
+    lock_guard<mutex> guard(shard.lock);
+
+    auto found = shard.index.find(key);
+    if (found != shard.index.end()) {
+        found->second->result = result;
+        shard.lru.splice(shard.lru.begin(), shard.lru, found->second);
+        return;
+    }
+
+    CacheEntry entry;
+    entry.key = key;
+    entry.result = result;
+    shard.lru.push_front(entry);
+    shard.index[key] = shard.lru.begin();
+
+    size_t limit = cache.capacity / CACHE_SHARDS;
+    if (limit == 0)
+        limit = 1;
+
+    while (shard.lru.size() > limit) {
+        shard.index.erase(shard.lru.back().key);
+        shard.lru.pop_back();
+    }
+}
+
+/*
+ *  loadCache()
+ *
+ *  Parameters: cache, name of cache file, current ruleset version
+ *  Does:       Maps the cache file into memory and stores every entry
+ *              simulated under the current ruleset, oldest first, so that
+ *              recency order survives between runs. Entries from any other
+ *              ruleset are dropped. A missing or malformed file is treated
+ *              as an empty cache.
+ *  Returns:    Number of entries loaded
+ */
+int loadCache(MatchupCache &cache, const string &file,
+              unsigned ruleset)
+{
+    int fd = open(file.c_str(), O_RDONLY);
+    if (fd < 0)
+        return 0;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 or (size_t)info.st_size < sizeof(CacheHeader)) {
+        close(fd);
+        return 0;
+    }
+
+    void *data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+        return 0;
+
+    const CacheHeader *header = (const CacheHeader *)data;
+    const CacheEntry *entries = (const CacheEntry *)(header + 1);
+    size_t room = (info.st_size - sizeof(CacheHeader)) / sizeof(CacheEntry);
+    int loaded = 0;
+
+    if (memcmp(header->magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) == 0
+        and header->format == CACHE_FORMAT
+        and header->recordSize == sizeof(CacheEntry)
+        and header->count <= room) {
+
+        for (unsigned long long i = 0; i < header->count; i++) {
+            if (entries[i].key.ruleset != ruleset)
+                continue;
+
+            storeMatchup(cache, entries[i].key, entries[i].result);
+            loaded++;
+        }
+    }
+
+    munmap(data, info.st_size);
+
+    return loaded;
+}
+
+/*
+ *  saveCache()
+ *
+ *  Parameters: cache, name of cache file
+ *  Does:       Sizes a temporary file (named for this process) to fit every
+ *              entry, maps it into memory, writes each shard's entries from
+ *              least to most recently used with their padding zeroed, syncs
+ *              it, and renames it over the cache file. Concurrent runs each
+ *              replace the file whole, so it is never left torn; the last
+ *              to finish wins.
+ *  Returns:    True if the file was written, otherwise false
+ */
+bool saveCache(MatchupCache &cache, const string &file)
+{
+    for (int i = 0; i < CACHE_SHARDS; i++)
+        cache.shards[i].lock.lock();
+
+    unsigned long long count = 0;
+    for (int i = 0; i < CACHE_SHARDS; i++)
+        count += cache.shards[i].lru.size();
+
+    size_t size = sizeof(CacheHeader) + count * sizeof(CacheEntry);
+    string temp = file + ".tmp." + to_string(getpid());
+    bool saved = false;
+
+    int fd = open(temp.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd >= 0 and ftruncate(fd, size) == 0) {
+        void *data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                          fd, 0);
+
+        if (data != MAP_FAILED) {
+            CacheHeader *header = (CacheHeader *)data;
+            CacheEntry *entries = (CacheEntry *)(header + 1);
+
+            memset(data, 0, size);
+            memcpy(header->magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+            header->format = CACHE_FORMAT;
+            header->recordSize = sizeof(CacheEntry);
+            header->count = count;
+
+            for (int i = 0; i < CACHE_SHARDS; i++) {
+                list<CacheEntry> &lru = cache.shards[i].lru;
+                for (auto it = lru.rbegin(); it != lru.rend(); it++) {
+                    entries->key = it->key;
+                    entries->result = it->result;
+                    entries++;
+                }
+            }
+
+            saved = msync(data, size, MS_SYNC) == 0;
+            munmap(data, size);
+        }
+    }
+    if (fd >= 0)
+        close(fd);
+
+    if (saved)
+        saved = rename(temp.c_str(), file.c_str()) == 0;
+    if (not saved)
+        unlink(temp.c_str());
+
+    for (int i = CACHE_SHARDS - 1; i >= 0; i--)
+        cache.shards[i].lock.unlock();
+
+    return saved;
+}
+
+/*
+ *  KeyHash, KeyEqual
+ *
+ *  Hash and compare matchup keys field by field (FNV-1a over the names).
+ */
+size_t KeyHash::operator()(const MatchupKey &key) const
+{
+    size_t hash = hashSide(2166136261u, key.attacker);
+
+    hash = hashSide(hash, key.defender);
+    hash = (hash ^ key.ruleset) * 16777619u;
+
+    return hash;
+}
+
+bool KeyEqual::operator()(const MatchupKey &a, const MatchupKey &b) const
+{
+    return a.ruleset == b.ruleset
+           and memcmp(&a.attacker, &b.attacker, sizeof(MatchupSide)) == 0
+           and memcmp(&a.defender, &b.defender, sizeof(MatchupSide)) == 0;
+}
+
+/*
+ *  hashSide()
+ *
+ *  Parameters: hash so far, one side of a matchup key
+ *  Does:       Folds the side's name, level, stats and type into the hash.
+ *  Returns:    The updated hash
+ */
+size_t hashSide(size_t hash, const MatchupSide &side)
+{
+    int fields[] = {side.level, side.HP, side.attack, side.defense,
+                    side.speed, side.type};
+
+    for (int i = 0; i < NAME_LEN and side.name[i] != '\0'; i++)
+        hash = (hash ^ (unsigned char)side.name[i]) * 16777619u;
+    for (int i = 0; i < 6; i++)
+        hash = (hash ^ (unsigned)fields[i]) * 16777619u;
+
+    return hash;
+}
+
+/*
+ *  shardFor()
+ *
+ *  Parameters: cache, matchup key
+ *  Does:       Picks the shard responsible for the key.
+ *  Returns:    Reference to the key's shard
+ */
+CacheShard &shardFor(MatchupCache &cache, const MatchupKey &key)
+{
+    return cache.shards[KeyHash()(key) % CACHE_SHARDS];
+}
+
+/*
+ *  stateProb()
+ *
+ *  Parameters: table of win probabilities, hits attacker and defender still
+ *              need, table width
+ *  Does:       Reads a state's win probability, treating states where either
+ *              Pokémon has already been knocked out as decided.
+ *  Returns:    Attacker's probability of winning from the state
+ */
+double stateProb(const double table[], int atkLeft, int defLeft, int cols)
+{
+    if (atkLeft <= 0)
+        return 1.0;
+    if (defLeft <= 0)
+        return 0.0;
+
+    return table[atkLeft * cols + defLeft];
+}
+
+/*
+ *  landProb()
+ *
+ *  Parameters: number of attacks, number that must land
+ *  Does:       Sums the binomial tail of attacks that do not miss.
+ *  Returns:    Probability at least that many of the attacks land
+ */
+double landProb(int attacks, int needed)
+{
+    if (needed <= 0)
+        return 1.0;
+    if (attacks < needed)
+        return 0.0;
+
+    double atLeast = 0;
+
+    // Binomial terms in log space, since long matchups underflow otherwise
+    for (int landed = needed; landed <= attacks; landed++)
+        atLeast += exp(lgamma(attacks + 1.0) - lgamma(landed + 1.0)
+                       - lgamma(attacks - landed + 1.0)
+                       + landed * log(1 - P_MISS)
+                       + (attacks - landed) * log(P_MISS));
+
+    return min(atLeast, 1.0);
+}
+
+/*
+ *  typeIndex()
+ *
+ *  Parameters: name of a Pokémon type
+ *  Does:       Finds the type's row/column in the type chart. Unknown types
+ *              are treated as normal, as in determineEffect().
+ *  Returns:    Index of the type in the type chart
+ */
+int typeIndex(const string &type)
+{
+    for (int i = 0; i < TYPE_COUNT; i++) {
+        if (type == TYPE_NAMES[i])
+            return i;
+    }
+
+    return 0;
+}
+
+/*
+ *  typeName()
+ *
+ *  Parameters: type chart index
+ *  Does:       Inverse of typeIndex().
+ *  Returns:    Name of the type
+ */
+string typeName(int index)
+{
+    return TYPE_NAMES[index];
+}
+
+/*
+ *  hitDamage()
+ *
+ *  Parameters: attacker's attack, defender's defense (units of
+ *              1/STAT_SCALE), attack effect (scaled by EFFECT_SCALE)
+ *  Does:       Computes the battle damage formula shared by battle() and
+ *              the matchup solvers: attack minus defense (or one whole
+ *              point, STAT_SCALE, if attack does not exceed defense),
+ *              multiplied by the type effect.
+ *  Returns:    Damage dealt by a regular (non-critical) hit, in units of
+ *              1/DAMAGE_SCALE
+ */
+int hitDamage(int attack, int defense, int effect)
+{
+    if (attack <= defense)
+        return STAT_SCALE * effect;
+
+    return (attack - defense) * effect;
+}
+
+/*
+ *  tScore()
+ *
+ *  Parameters: two-sided normal critical value, degrees of freedom
+ *  Does:       Widens the normal critical value to Student's t with the
+ *              Cornish-Fisher expansion, so intervals from only a few
+ *              batches are not overconfident.
+ *  Returns:    Approximate two-sided t critical value
+ */
+double tScore(double z, long freedom)
+{
+    double z2 = z * z;
+    double n = freedom;
+
+    return z + z * (z2 + 1) / (4 * n)
+             + z * ((5 * z2 + 16) * z2 + 3) / (96 * n * n)
+             + z * (((3 * z2 + 19) * z2 + 17) * z2 - 15) / (384 * n * n * n);
+}
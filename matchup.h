@@ -0,0 +1,158 @@
+/*
+ *      matchup.h
+ *
+ *      Purpose: Simulated matchup results between two Pokémon at given
+ *               levels, and a sharded LRU cache of those results that is
+ *               persisted to a memory-mapped file between runs.
+ *
+ *      Last modified: October 19, 2026
+ */
+
+#ifndef MATCHUP_H
+#define MATCHUP_H
+
+#include <list>
+#include <mutex>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "pokemon.h"
+
+/* Bump whenever the damage formula or battle rules change. The type chart is
+ * hashed into the ruleset separately (see rulesetVersion()). */
+const unsigned RULESET_VERSION = 3;
+
+const int NAME_LEN      = 16;
+const int HP_BUCKETS    = 10;
+const int CACHE_SHARDS  = 16;
+const int NO_KO         = 0;
+const int TYPE_COUNT    = 18;
+
+/* Per-attack outcome probabilities: 1 in 20 attacks miss, and 1 in 20 of the
+ * attacks that land are critical (worth two regular hits). */
+const double P_MISS = 1.0 / 20;
+const double P_CRIT = (19.0 / 20) * (1.0 / 20);
+const double P_HIT  = (19.0 / 20) * (19.0 / 20);
+
+/*
+ * MatchupSide, MatchupKey
+ *
+ * Identifies a matchup: each Pokémon's species, level, stats at that level
+ * (units of 1/STAT_SCALE) and type chart index, and the ruleset the result
+ * was simulated under. The stats and types are part of the key since the
+ * same species can appear with different stats (in the Pokédex and on a
+ * route, or on two lines of one route). Plain data with no padding, so it
+ * can be written to and read from the cache file as-is.
+ */
+struct MatchupSide {
+    char name[NAME_LEN];
+    int level;
+    int HP;
+    int attack;
+    int defense;
+    int speed;
+    int type;
+};
+
+struct MatchupKey {
+    MatchupSide attacker;
+    MatchupSide defender;
+    unsigned ruleset;
+};
+
+/*
+ * MatchupResult
+ *
+ * Outcome of a simulated matchup: the attacker's probability of winning
+ * and the half-width of its confidence interval, expected number of turns,
+ * the distribution of the attacker's remaining HP fraction at the end of
+ * battle (bucket 0 includes losses), and the number of battles sampled.
+ */
+struct MatchupResult {
+    double winProb;
+    double halfWidth;
+    double expTurns;
+    double hpDist[HP_BUCKETS];
+    int samples;
+};
+
+/*
+ * MatchupClass
+ *
+ * Everything a battle's outcome depends on: how many regular hits each
+ * Pokémon needs to knock out the other (NO_KO if it deals no damage), and
+ * whether the attacker moves first. Matchups with equal classes have equal
+ * win probabilities, whatever their stats and levels.
+ */
+struct MatchupClass {
+    int atkHits;
+    int defHits;
+    bool atkFirst;
+};
+
+/*
+ * CacheEntry, CacheShard
+ *
+ * A shard holds its own LRU list (most recent at the front) and index into
+ * it, guarded by its own lock so separate shards can be used concurrently.
+ */
+struct CacheEntry {
+    MatchupKey key;
+    MatchupResult result;
+};
+
+struct KeyHash {
+    size_t operator()(const MatchupKey &key) const;
+};
+
+struct KeyEqual {
+    bool operator()(const MatchupKey &a, const MatchupKey &b) const;
+};
+
+struct CacheShard {
+    std::mutex lock;
+    std::list<CacheEntry> lru;
+    std::unordered_map<MatchupKey, std::list<CacheEntry>::iterator,
+                       KeyHash, KeyEqual> index;
+};
+
+/*
+ * MatchupCache
+ *
+ * Sharded in-memory matchup cache. Each shard evicts its least recently
+ * used entry once it holds more than capacity / CACHE_SHARDS entries.
+ */
+struct MatchupCache {
+    size_t capacity;
+    CacheShard shards[CACHE_SHARDS];
+};
+
+unsigned rulesetVersion(const std::vector< std::vector<int> > &typeChart);
+MatchupKey makeKey(const Pokemon &attacker, int atkLevel,
+                   const Pokemon &defender, int defLevel, unsigned ruleset);
+MatchupResult simulateMatchup(const Pokemon &attacker, const Pokemon &defender,
+                              const std::vector< std::vector<int> > &typeChart,
+                              double precision, double confidence,
+                              std::mt19937 &rng);
+int typeIndex(const std::string &type);
+std::string typeName(int index);
+int hitDamage(int attack, int defense, int effect);
+int hitsToKO(int HP, int damage);
+MatchupClass classifyMatchup(const Pokemon &attacker, const Pokemon &defender,
+                             const std::vector< std::vector<int> > &typeChart);
+long long classKey(const MatchupClass &matchup);
+double winProbability(const MatchupClass &matchup);
+void winBounds(const MatchupClass &matchup, double &low, double &high);
+
+void initCache(MatchupCache &cache, size_t capacity);
+bool lookupMatchup(MatchupCache &cache, const MatchupKey &key,
+                   MatchupResult &result);
+void storeMatchup(MatchupCache &cache, const MatchupKey &key,
+                  const MatchupResult &result);
+int loadCache(MatchupCache &cache, const std::string &file,
+              unsigned ruleset);
+bool saveCache(MatchupCache &cache, const std::string &file);
+
+#endif
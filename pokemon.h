@@ -0,0 +1,44 @@
+/*
+ *      pokemon.h
+ *
+ *      Purpose: Shared description of a single Pokémon, and the fixed-point
+ *               scales every stat, effect, and damage value is stored in.
+ *
+ *      Last modified: October 19, 2026
+ */
+
+#ifndef POKEMON_H
+#define POKEMON_H
+
+#include <string>
+
+/* Stats are integers in units of 1/STAT_SCALE of a stat point. Pokédex stats
+ * are the average of two whole numbers divided by 100, and route stats have
+ * two decimals, so 1/200 represents both exactly. */
+const int STAT_SCALE = 200;
+
+/* Type effects are integers scaled by EFFECT_SCALE, which covers 0, 0.25,
+ * 0.5, 1, 2 and 4 exactly (0, 1, 2, 4, 8, 16). */
+const int EFFECT_SCALE = 4;
+
+/* Damage and HP during battle are in units of 1/DAMAGE_SCALE, so that
+ * (attack - defense) x effect never needs rounding. */
+const int DAMAGE_SCALE = STAT_SCALE * EFFECT_SCALE;
+
+/*
+ * Pokémon
+ *
+ * Describes a single Pokémon: its name, type, stats (speed, attack, defense,
+ * HP) in units of 1/STAT_SCALE, and level of next evolution.
+ */
+struct Pokemon {
+    std::string name;
+    int HP;
+    int attack;
+    int defense;
+    int speed;
+    std::string type;
+    int nextEvol;
+};
+
+#endif
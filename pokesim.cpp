@@ -0,0 +1,500 @@
+/*
+ *      pokesim.cpp
+ *
+ *      Purpose: Simulation core of libpokesim. Loads the Pokédex and routes,
+ *               computes stats by level, spawns encounters, and runs battles
+ *               following the original franchise's computational methods.
+ *               Works only on the SimContext passed in and reports through
+ *               return values, never through cin/cout.
+ *
+ *      Last modified: October 19, 2026
+ */
+
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <stdexcept>
+
+#include "pokesim.h"
+
+using namespace std;
+
+/*
+ *  initContext()
+ *
+ *  Parameters: context, seed for the context's random number generator
+ *  Does:       Empties the Pokédex and route, populates the type chart, and
+ *              seeds the context's random number generator.
+ *  Returns:    NA
+ */
+void initContext(SimContext &ctx, unsigned seed)
+{
+    ctx.pokedex.clear();
+    ctx.columns = DexColumns();
+    ctx.route.clear();
+    ctx.range.low = 0;
+    ctx.range.high = 0;
+    populateChart(ctx.typeChart);
+    ctx.rng.seed(seed);
+}
+
+/*  populateChart()
+ *
+ *  Parameters: Pokémon type chart represented as a 2D vector of effects
+ *              scaled by EFFECT_SCALE, where super effective, normal, not very
+ *              effective, and no effect type matchups are represented as
+ *              8, 4, 2, and 0 (2.0, 1.0, 0.5, and 0).
+ *              Chart: https://rankedboost.com/pokemon-sun-moon/type-chart/
+ *  Does:       Fills the typeChart vector that is passed in.
+ *  Returns:    NA
+ */
+void populateChart(vector< vector<int> > &typeChart)
+{
+    typeChart = { {4, 4, 4, 4, 4, 2, 4, 0, 2, 4, 4, 4, 4, 4, 4, 4, 4, 4},
+                  {8, 4, 2, 2, 4, 8, 2, 0, 8, 4, 4, 4, 4, 2, 8, 4, 8, 2},
+                  {4, 8, 4, 4, 4, 2, 8, 4, 2, 4, 4, 8, 2, 4, 4, 4, 4, 4},
+                  {4, 4, 4, 2, 2, 2, 4, 2, 0, 4, 4, 8, 4, 4, 4, 4, 4, 8},
+                  {4, 4, 0, 8, 4, 8, 2, 4, 8, 8, 4, 2, 8, 4, 4, 4, 4, 4},
+                  {4, 2, 8, 4, 2, 4, 8, 4, 2, 8, 4, 4, 4, 4, 8, 4, 4, 4},
+                  {4, 2, 2, 2, 4, 4, 4, 2, 2, 2, 4, 8, 4, 8, 4, 4, 8, 2},
+                  {0, 4, 4, 4, 4, 4, 4, 8, 4, 4, 4, 4, 4, 8, 4, 4, 2, 4},
+                  {4, 4, 4, 4, 4, 8, 4, 4, 2, 2, 2, 4, 2, 4, 8, 4, 4, 8},
+                  {4, 4, 4, 4, 4, 2, 8, 4, 8, 2, 2, 8, 4, 4, 8, 2, 4, 4},
+                  {4, 4, 4, 4, 8, 8, 4, 4, 4, 8, 2, 2, 4, 4, 4, 2, 4, 4},
+                  {4, 4, 2, 2, 8, 8, 2, 4, 2, 2, 8, 2, 4, 4, 4, 2, 4, 4},
+                  {4, 4, 8, 4, 0, 4, 4, 4, 4, 4, 8, 2, 2, 4, 4, 2, 4, 4},
+                  {4, 8, 4, 8, 4, 4, 4, 4, 2, 4, 4, 4, 4, 2, 4, 4, 0, 4},
+                  {4, 4, 8, 4, 8, 4, 4, 4, 2, 2, 2, 8, 4, 4, 2, 8, 4, 4},
+                  {4, 4, 4, 4, 4, 4, 4, 4, 2, 4, 4, 4, 4, 4, 4, 8, 4, 0},
+                  {4, 2, 4, 4, 4, 4, 4, 8, 4, 4, 4, 4, 4, 8, 4, 4, 2, 2},
+                  {4, 8, 4, 2, 4, 4, 4, 4, 2, 2, 4, 4, 4, 4, 4, 8, 8, 4} };
+}
+
+/*
+ *  populateDex()
+ *
+ *  Parameters: context, name of pokedex file, error message to populate
+ *  Does:       Populates the context's Pokédex with information from file
+ *              regarding each Pokémon's name, HP, attack, defense, and speed,
+ *              then rebuilds the compact Pokédex columns. Lines are read
+ *              into one reused buffer and parsed in place. Blank lines are
+ *              skipped.
+ *  Returns:    True if the file could be opened and every value fits the
+ *              compact columns, otherwise false with the error set
+ */
+bool populateDex(SimContext &ctx, const string &dexFile, string &error)
+{
+    ifstream input;
+    string info;
+
+    input.open(dexFile);
+    if (not input.is_open()) {
+        error = "cannot open Pokédex";
+        return false;
+    }
+
+    string name, type;
+    int nextEvol = 0;
+    int maxHP = 0, maxAtk = 0, maxDef = 0, spAtk = 0, spDef = 0, maxSpd = 0;
+
+    while (getline(input, info)) {
+        const char *text = readWord(info.c_str(), name);
+        if (name.empty())
+            continue;
+
+        text = readInt(text, maxHP);
+        text = readInt(text, maxAtk);
+        text = readInt(text, maxDef);
+        text = readInt(text, spAtk);
+        text = readInt(text, spDef);
+        text = readInt(text, maxSpd);
+        text = readWord(text, type);
+        readInt(text, nextEvol);
+
+        ctx.pokedex.push_back(calculateStats(name, maxHP, maxAtk, maxDef,
+                                             spAtk, spDef, maxSpd, type,
+                                             nextEvol));
+    }
+
+    try {
+        buildColumns(ctx.pokedex, ctx.columns);
+    } catch (const overflow_error &e) {
+        error = e.what();
+        return false;
+    }
+
+    return true;
+}
+
+/*
+ *  calculateStats()
+ *
+ *  Parameters: Pokémon's name, type, maximum HP, attack, defense, special
+ *              attack, special defense, and speed stats.
+ *  Does:       Divides the max stat values by 100 (attack and defense are
+ *              averaged with their special counterparts) and populates entry
+ *              struct, exactly, in units of 1/STAT_SCALE.
+ *  Returns:    A Pokémon struct with respective stats populated.
+ */
+Pokemon calculateStats(const string &name, int maxHP, int maxAtk, int maxDef,
+                       int spAtk, int spDef, int maxSpd, const string &type,
+                       int nextEvol)
+{
+    Pokemon entry;
+
+    entry.name = name;
+    entry.HP = maxHP * STAT_SCALE / 100;
+    entry.attack = (maxAtk + spAtk) * STAT_SCALE / 200;
+    entry.defense = (maxDef + spDef) * STAT_SCALE / 200;
+    entry.speed = maxSpd * STAT_SCALE / 100;
+    entry.type = type;
+    entry.nextEvol = nextEvol;
+
+    return entry;
+}
+
+/*
+ *  searchDex()
+ *
+ *  Parameters: context, name of Pokémon
+ *  Does:       Searches through the Pokédex for the specific Pokémon.
+ *  Returns:    Index with which specific Pokémon is found at, otherwise -1
+ */
+int searchDex(const SimContext &ctx, const string &pokemon)
+{
+    int index = -1;
+
+    for (unsigned long i = 0; i < ctx.pokedex.size(); i++) {
+        if (ctx.pokedex[i].name == pokemon)
+            index = i;
+    }
+
+    return index;
+}
+
+/*
+ *  toFixed(), fromFixed()
+ *
+ *  Parameters: value / fixed-point value, scale
+ *  Does:       Converts between a value and its fixed-point representation
+ *              in units of 1/scale, rounding to the nearest unit.
+ *  Returns:    The converted value
+ */
+int toFixed(double value, int scale)
+{
+    return (int)lround(value * scale);
+}
+
+double fromFixed(int value, int scale)
+{
+    return (double)value / scale;
+}
+
+/*
+ *  roundStat()
+ *
+ *  Parameters: stat in units of 1/STAT_SCALE
+ *  Does:       Rounds the stat to the nearest whole number, halves up.
+ *  Returns:    The rounded stat
+ */
+int roundStat(int stat)
+{
+    return (stat + STAT_SCALE / 2) / STAT_SCALE;
+}
+
+/*
+ *  levelStats()
+ *
+ *  Parameters: Pokémon with base (level 1) stats, level
+ *  Does:       Multiplies HP, attack, defense, and speed by the level.
+ *  Returns:    The Pokémon with stats at the given level
+ */
+Pokemon levelStats(const Pokemon &base, int level)
+{
+    Pokemon mon = base;
+
+    mon.HP      = base.HP      * level;
+    mon.attack  = base.attack  * level;
+    mon.defense = base.defense * level;
+    mon.speed   = base.speed   * level;
+
+    return mon;
+}
+
+/*
+ *  evolution()
+ *
+ *  Parameters: context, index of Pokédex Pokémon, level
+ *  Does:       Determines whether the Pokémon evolves at the given level.
+ *              Evolutions follow their pre-evolution in the Pokédex, except
+ *              Eevee's, which the player has to choose between.
+ *  Returns:    Index of the evolved form, NO_EVOLUTION, or EVOLUTION_CHOICE
+ */
+int evolution(const SimContext &ctx, int index, int level)
+{
+    const Pokemon &mon = ctx.pokedex[index];
+
+    if (mon.nextEvol == 0 or level < mon.nextEvol)
+        return NO_EVOLUTION;
+
+    if (mon.name == "eevee")
+        return EVOLUTION_CHOICE;
+
+    return index + 1;
+}
+
+/*  populateRoute()
+ *
+ *  Parameters: context, file name of route
+ *  Does:       Parses file contents and populates the context's route
+ *              Pokémon and route's level range, parsing each line in place
+ *              like populateDex().
+ *  Returns:    True if the file could be opened, otherwise false
+ */
+bool populateRoute(SimContext &ctx, const string &file)
+{
+    ifstream input;
+    string info;
+
+    input.open(file);
+    if (not input.is_open())
+        return false;
+
+    getline(input, info);
+    // Obtain's route's range of levels
+    readInt(readInt(info.c_str(), ctx.range.low), ctx.range.high);
+
+    while(getline(input, info)) {
+        // Creates Pokémon, converting two-decimal stats to fixed point
+        Pokemon mon;
+        const char *text = readWord(info.c_str(), mon.name);
+        if (mon.name.empty())
+            continue;
+
+        double HP = 0, attack = 0, defense = 0, speed = 0;
+        text = readDouble(text, HP);
+        text = readDouble(text, attack);
+        text = readDouble(text, defense);
+        text = readDouble(text, speed);
+        readWord(text, mon.type);
+        mon.HP = toFixed(HP, STAT_SCALE);
+        mon.attack = toFixed(attack, STAT_SCALE);
+        mon.defense = toFixed(defense, STAT_SCALE);
+        mon.speed = toFixed(speed, STAT_SCALE);
+        mon.nextEvol = 0;
+
+        ctx.route.push_back(mon);
+    }
+
+    return true;
+}
+
+/*
+ *  routeName()
+ *
+ *  Parameters: path of route file
+ *  Does:       Strips the directory and extension (routes/route1.txt gives
+ *              route1).
+ *  Returns:    The route's name
+ */
+string routeName(string file)
+{
+    unsigned long slash = file.find_last_of('/');
+    if (slash != string::npos)
+        file = file.substr(slash + 1);
+
+    unsigned long dot = file.find_last_of('.');
+    if (dot != string::npos)
+        file = file.substr(0, dot);
+
+    return file;
+}
+
+/*  spawn()
+ *
+ *  Parameters: context, Pokémon to populate
+ *  Does:       Randomly generates a Pokémon from the route to spawn and its
+ *              level based on the route's range. Populates encountered
+ *              Pokémon's stats.
+ *  Returns:    The level of the spawned Pokémon, or -1 if the route is
+ *              empty.
+ */
+int spawn(SimContext &ctx, Pokemon &encounter)
+{
+    if (ctx.route.empty())
+        return -1;
+
+    uniform_int_distribution<int> slot(0, ctx.route.size() - 1);
+    uniform_int_distribution<int> levels(ctx.range.low, ctx.range.high);
+
+    int index = slot(ctx.rng);
+    int level = levels(ctx.rng);
+
+    encounter = levelStats(ctx.route[index], level);
+
+    return level;
+}
+
+/*
+ *  determineEffect()
+ *
+ *  Parameters: context, attacking and defending Pokémon
+ *  Does:       Determines the numerical "effect" of the attacking Pokémon's
+ *              attack based on the type advantage, using the typeChart. If
+ *              attack is SUPER EFFECTIVE, NEUTRAL, NOT VERY EFFECTIVE, or
+ *              NO EFFECT, attack power is multiplied by 2.0, 1.0, 0.5, and 0,
+ *              respectively.
+ *  Returns:    Attack effect scaled by EFFECT_SCALE (8, 4, 2, or 0)
+ */
+int determineEffect(const SimContext &ctx, const Pokemon &attacker,
+                    const Pokemon &defender)
+{
+    return ctx.typeChart[typeIndex(attacker.type)][typeIndex(defender.type)];
+}
+
+/*
+ *  battle()
+ *
+ *  Parameters: context, two battling Pokémon, optional log of turns
+ *  Does:       Drives automated battle, deducting damage from each Pokémon's
+ *              HP in integer units of 1/DAMAGE_SCALE. The faster Pokémon
+ *              attacks first (mon2 on a tie). Ends when either Pokémon's HP
+ *              drops to 0 or below. If neither Pokémon can do damage (each
+ *              is immune to the other's type), the battle is decided at once
+ *              as a loss for mon1, with no turns taken. Records every turn
+ *              in log if one is given.
+ *  Returns:    Whether mon1 won, and number of turns taken
+ */
+BattleResult battle(SimContext &ctx, const Pokemon &mon1, const Pokemon &mon2,
+                    vector<TurnEvent> *log)
+{
+    BattleResult result;
+    bool first = mon1.speed > mon2.speed;
+    int HP1 = mon1.HP * EFFECT_SCALE;
+    int HP2 = mon2.HP * EFFECT_SCALE;
+    int turns = 0;
+
+    if (hitDamage(mon1.attack, mon2.defense,
+                  determineEffect(ctx, mon1, mon2)) == 0
+        and hitDamage(mon2.attack, mon1.defense,
+                      determineEffect(ctx, mon2, mon1)) == 0) {
+        result.firstWon = false;
+        result.turns = 0;
+        return result;
+    }
+
+    do {
+        const Pokemon &attacker = first ? mon1 : mon2;
+        const Pokemon &defender = first ? mon2 : mon1;
+        int &defenderHP = first ? HP2 : HP1;
+
+        TurnEvent event;
+        event.turn = turns + 1;
+        event.firstAttacking = first;
+        event.effect = determineEffect(ctx, attacker, defender);
+        event.missed = calcMiss(ctx);
+        event.damage = 0;
+        event.crit = false;
+
+        if (not event.missed) {
+            event.damage = hitDamage(attacker.attack, defender.defense,
+                                     event.effect);
+
+            // Determines if attack is critical hit. If so, damage is doubled
+            event.crit = calcCrit(ctx);
+            if (event.crit == true)
+                defenderHP -= (event.damage * 2);
+            else
+                defenderHP -= event.damage;
+        }
+
+        event.HP1 = HP1;
+        event.HP2 = HP2;
+        if (log != NULL)
+            log->push_back(event);
+
+        turns++;
+        first = not first;
+    } while (HP1 > 0 and HP2 > 0);
+
+    result.firstWon = HP2 <= 0;
+    result.turns = turns;
+
+    return result;
+}
+
+/*
+ *  calcMiss()
+ *
+ *  Parameters: context
+ *  Does:       Determines whether attack missed using the context's random
+ *              number generator.
+ *  Returns:    True if attack missed, otherwise false
+ */
+bool calcMiss(SimContext &ctx)
+{
+    uniform_int_distribution<int> d20(1, 20);
+
+    return d20(ctx.rng) == 1;
+}
+
+/*
+ *  calcCrit()
+ *
+ *  Parameters: context
+ *  Does:       Determines whether attack is critical hit using the context's
+ *              random number generator.
+ *  Returns:    True if attack is critical, otherwise false
+ */
+bool calcCrit(SimContext &ctx)
+{
+    uniform_int_distribution<int> d20(1, 20);
+
+    return d20(ctx.rng) == 20;
+}
+
+/*
+ *  readWord(), readInt(), readDouble()
+ *
+ *  Parameters: text to parse, field to populate
+ *  Does:       Skips whitespace and parses the next field of a line. A
+ *              word is copied into the existing string (reusing its
+ *              storage); a number that is missing leaves the field as is.
+ *  Returns:    Pointer just past the parsed field
+ */
+const char *readWord(const char *text, string &word)
+{
+    while (isspace((unsigned char)*text))
+        text++;
+
+    const char *end = text;
+    while (*end != '\0' and not isspace((unsigned char)*end))
+        end++;
+
+    word.assign(text, end - text);
+
+    return end;
+}
+
+const char *readInt(const char *text, int &value)
+{
+    char *end;
+    long parsed = strtol(text, &end, 10);
+
+    if (end != text)
+        value = parsed;
+
+    return end;
+}
+
+const char *readDouble(const char *text, double &value)
+{
+    char *end;
+    double parsed = strtod(text, &end);
+
+    if (end != text)
+        value = parsed;
+
+    return end;
+}
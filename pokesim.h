@@ -0,0 +1,117 @@
+/*
+ *      pokesim.h
+ *
+ *      Purpose: Interface to libpokesim, the simulation core shared by battle,
+ *               catch, stats, and sweep. All state lives in a SimContext that
+ *               the caller owns; the core keeps no globals and does no
+ *               console I/O, so separate contexts can be used concurrently
+ *               (for example, one per thread or per game server session).
+ *
+ *      Last modified: October 19, 2026
+ */
+
+#ifndef POKESIM_H
+#define POKESIM_H
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "pokemon.h"
+#include "matchup.h"
+#include "compactdex.h"
+
+const int NO_EVOLUTION     = -1;
+const int EVOLUTION_CHOICE = -2;
+
+/* Turns a battle log reserves before battle() fills it, so logging does
+ * not allocate mid-battle unless a battle runs longer than this. */
+const int LOG_TURNS = 4096;
+
+/*
+ * Range
+ *
+ * Describes the range (low - high) of pokemon levels that can be
+ * caught on the current route.
+ */
+struct Range {
+    int low;
+    int high;
+};
+
+/*
+ * SimContext
+ *
+ * Everything a simulation needs: the Pokédex (also as compact columns), the
+ * current route and its level range, the type chart, and the context's own
+ * random number generator.
+ */
+struct SimContext {
+    std::vector<Pokemon> pokedex;
+    DexColumns columns;
+    std::vector<Pokemon> route;
+    Range range;
+    std::vector< std::vector<int> > typeChart;
+    std::mt19937 rng;
+};
+
+/*
+ * TurnEvent
+ *
+ * What happened on one turn of a battle, so front ends can narrate it:
+ * who attacked, the attack's effect (scaled by EFFECT_SCALE), whether it
+ * missed or was critical, the damage of a regular hit, and both Pokémon's
+ * HP afterwards (both in units of 1/DAMAGE_SCALE).
+ */
+struct TurnEvent {
+    int turn;
+    bool firstAttacking;
+    int effect;
+    bool missed;
+    int damage;
+    bool crit;
+    int HP1;
+    int HP2;
+};
+
+/*
+ * BattleResult
+ *
+ * Outcome of a battle: whether the first Pokémon passed to battle() won,
+ * and how many turns it took.
+ */
+struct BattleResult {
+    bool firstWon;
+    int turns;
+};
+
+void initContext(SimContext &ctx, unsigned seed);
+void populateChart(std::vector< std::vector<int> > &typeChart);
+
+bool populateDex(SimContext &ctx, const std::string &dexFile,
+                 std::string &error);
+Pokemon calculateStats(const std::string &name, int maxHP, int maxAtk,
+                       int maxDef, int spAtk, int spDef, int maxSpd,
+                       const std::string &type, int nextEvol);
+int searchDex(const SimContext &ctx, const std::string &pokemon);
+int toFixed(double value, int scale);
+double fromFixed(int value, int scale);
+int roundStat(int stat);
+Pokemon levelStats(const Pokemon &base, int level);
+int evolution(const SimContext &ctx, int index, int level);
+
+bool populateRoute(SimContext &ctx, const std::string &file);
+std::string routeName(std::string file);
+const char *readWord(const char *text, std::string &word);
+const char *readInt(const char *text, int &value);
+const char *readDouble(const char *text, double &value);
+int spawn(SimContext &ctx, Pokemon &encounter);
+
+int determineEffect(const SimContext &ctx, const Pokemon &attacker,
+                    const Pokemon &defender);
+BattleResult battle(SimContext &ctx, const Pokemon &mon1, const Pokemon &mon2,
+                    std::vector<TurnEvent> *log);
+bool calcMiss(SimContext &ctx);
+bool calcCrit(SimContext &ctx);
+
+#endif
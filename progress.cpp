@@ -0,0 +1,649 @@
+/*
+ *      progress.cpp
+ *
+ *      Purpose: Plays virtual trainers through the routes in order, to check
+ *               that the routes work as a progression. Every trainer starts
+ *               with a starter, battles spawns with whichever party member
+ *               is most likely to win, catches what it beats (as catch
+ *               does), gains experience, levels up and evolves, and moves on
+ *               once its strongest Pokémon reaches the next route's lowest
+ *               level. Trainers run in parallel, each on its own random
+ *               streams, and the level and catch curves, where trainers
+ *               stall, and how long the whole progression takes are
+ *               reported.
+ *
+ *      Last modified: October 19, 2026
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "pokesim.h"
+
+using namespace std;
+
+const int MAX_LEVEL = 100;
+const int MAX_ROUTES = 16;
+const int PARTY_SIZE = 6;
+const int STARTER_LEVEL = 5;
+const int ENCOUNTER_BUDGET = 500;
+const unsigned PROGRESS_SEED = 20200601;
+
+/* Win probabilities within SETTLED of each other are treated as equal when
+ * choosing a party member, so bounds that close need no exact solve. */
+const double SETTLED = 1e-9;
+
+const int STARTER_COUNT = 3;
+const char *STARTERS[STARTER_COUNT] = {"bulbasaur", "charmander", "squirtle"};
+
+/*
+ * RouteStage
+ *
+ * One route of the progression: its context (spawns, level range, type
+ * chart and random number generator), its name, the level a trainer's
+ * strongest Pokémon must reach to move on (the next route's lowest level,
+ * or the last route's highest), and each spawn's slot on the route by name
+ * with its Pokédex index per slot (-1 if the Pokédex lacks it).
+ */
+struct RouteStage {
+    SimContext ctx;
+    string name;
+    int gate;
+    unordered_map<string, int> slots;
+    vector<int> dexIndex;
+};
+
+/*
+ * Member
+ *
+ * A party Pokémon: its Pokédex index (-1 for a route species the Pokédex
+ * lacks, which never evolves), level 1 stats, level, experience toward the
+ * next level, and stats at its level.
+ */
+struct Member {
+    int species;
+    Pokemon base;
+    int level;
+    int xp;
+    Pokemon mon;
+};
+
+/*
+ * Odds
+ *
+ * What is known of a matchup class's win probability: its bounds, and its
+ * exact value once solved.
+ */
+struct Odds {
+    double low;
+    double high;
+    bool solved;
+    double exact;
+};
+
+/*
+ * TrainerRun
+ *
+ * How far one trainer got: its starter, the routes it cleared, and per
+ * route its encounters, catches (battles won), and its party's mean level
+ * (rounded down) when it left or stalled on the route.
+ */
+struct TrainerRun {
+    int starter;
+    int cleared;
+    int encounters[MAX_ROUTES];
+    int catches[MAX_ROUTES];
+    int level[MAX_ROUTES];
+};
+
+bool setupStage(RouteStage &stage, const SimContext &dex, string file);
+void runTrainers(const SimContext &dex, const vector<RouteStage> &shared,
+                 vector<TrainerRun> &runs, unsigned first, unsigned step);
+void playTrainer(const SimContext &dex, vector<RouteStage> &stages,
+                 unordered_map<long long, Odds> &known, unsigned trainer,
+                 TrainerRun &run);
+Member makeMember(const SimContext &dex, const Pokemon &base, int species,
+                  int level);
+int bestMember(const vector<Member> &party, const Pokemon &encounter,
+               const vector< vector<int> > &typeChart,
+               unordered_map<long long, Odds> &known);
+bool dominates(const MatchupClass &a, const MatchupClass &b);
+void gainExperience(const SimContext &dex, Member &member, int xp);
+void evolve(const SimContext &dex, Member &member);
+void addToParty(vector<Member> &party, const Member &caught);
+int strongest(const vector<Member> &party);
+int partyLevel(const vector<Member> &party);
+void reportProgress(const vector<RouteStage> &stages,
+                    const vector<TrainerRun> &runs);
+int percentile(vector<int> values, double fraction);
+
+int main(int argc, char* argv[])
+{
+    if (argc < 4 or argc - 3 > MAX_ROUTES) {
+        cout << "Usage: ./progress [pokedex] [trainers] [route]..." << endl;
+        return 1;
+    }
+
+    SimContext dex;
+    string error;
+    int trainers = atoi(argv[2]);
+    int count = argc - 3;
+
+    if (trainers < 1) {
+        cerr << "Trainers must be at least 1." << endl;
+        return 1;
+    }
+
+    initContext(dex, 0);
+    if (not populateDex(dex, argv[1], error)) {
+        cerr << argv[1] << ": " << error << "." << endl;
+        return 1;
+    }
+    for (int i = 0; i < STARTER_COUNT; i++) {
+        if (searchDex(dex, STARTERS[i]) == -1) {
+            cerr << STARTERS[i] << ": starter not in Pokédex." << endl;
+            return 1;
+        }
+    }
+
+    vector<RouteStage> stages(count);
+    for (int i = 0; i < count; i++) {
+        if (not setupStage(stages[i], dex, argv[i + 3])) {
+            cerr << argv[i + 3] << ": cannot read route." << endl;
+            return 1;
+        }
+    }
+    for (int i = 0; i < count; i++) {
+        stages[i].gate = (i + 1 < count) ? stages[i + 1].ctx.range.low
+                                         : stages[i].ctx.range.high;
+    }
+
+    // Trainers are striped across threads; each thread has its own copy of
+    // the routes, and each trainer seeds its own streams
+    vector<TrainerRun> runs(trainers);
+    unsigned workers = max(1u, thread::hardware_concurrency());
+    workers = min(workers, (unsigned)trainers);
+
+    auto start = chrono::steady_clock::now();
+    vector<thread> pool;
+    for (unsigned i = 0; i < workers; i++)
+        pool.push_back(thread(runTrainers, cref(dex), cref(stages), ref(runs),
+                              i, workers));
+    for (unsigned i = 0; i < workers; i++)
+        pool[i].join();
+    chrono::duration<double> span = chrono::steady_clock::now() - start;
+
+    cout << trainers << " trainers played through " << count
+         << " route(s) on " << workers << " thread(s) in " << span.count()
+         << " s" << endl;
+    reportProgress(stages, runs);
+
+    return 0;
+}
+
+/*
+ *  setupStage()
+ *
+ *  Parameters: stage to set up, context with loaded Pokédex, route file
+ *  Does:       Loads the route into the stage's own context and looks up
+ *              each spawn in the Pokédex (route names are capitalized).
+ *  Returns:    True if the route could be read and has spawns
+ */
+bool setupStage(RouteStage &stage, const SimContext &dex, string file)
+{
+    initContext(stage.ctx, 0);
+    if (not populateRoute(stage.ctx, file) or stage.ctx.route.empty())
+        return false;
+
+    stage.name = routeName(file);
+    stage.gate = 0;
+    stage.slots.clear();
+    stage.dexIndex.clear();
+
+    for (unsigned long i = 0; i < stage.ctx.route.size(); i++) {
+        string name = stage.ctx.route[i].name;
+
+        for (unsigned long c = 0; c < name.size(); c++)
+            name[c] = tolower((unsigned char)name[c]);
+
+        stage.slots[stage.ctx.route[i].name] = i;
+        stage.dexIndex.push_back(searchDex(dex, name));
+    }
+
+    return true;
+}
+
+/*
+ *  runTrainers()
+ *
+ *  Parameters: context with loaded Pokédex, stages, runs to fill, first
+ *              trainer, stride
+ *  Does:       Plays every step-th trainer from first on, on this thread's
+ *              copy of the stages, sharing what the thread knows of each
+ *              matchup class's odds between its trainers.
+ *  Returns:    NA
+ */
+void runTrainers(const SimContext &dex, const vector<RouteStage> &shared,
+                 vector<TrainerRun> &runs, unsigned first, unsigned step)
+{
+    vector<RouteStage> stages = shared;
+    unordered_map<long long, Odds> known;
+
+    for (unsigned t = first; t < runs.size(); t += step)
+        playTrainer(dex, stages, known, t, runs[t]);
+}
+
+/*
+ *  playTrainer()
+ *
+ *  Parameters: context with loaded Pokédex, this thread's stages, odds
+ *              known so far by matchup class, trainer number, run to fill
+ *  Does:       Starts the trainer with STARTERS[trainer % STARTER_COUNT] at
+ *              STARTER_LEVEL and plays the routes in order. On each route
+ *              the trainer battles spawns with its best party member until
+ *              its strongest Pokémon reaches the route's gate, or stalls
+ *              after ENCOUNTER_BUDGET encounters. Each route's random
+ *              stream is seeded from the trainer and route numbers, so runs
+ *              do not depend on the thread count. A won battle is a catch,
+ *              and gives the winner the encounter's level in experience.
+ *  Returns:    NA
+ */
+void playTrainer(const SimContext &dex, vector<RouteStage> &stages,
+                 unordered_map<long long, Odds> &known, unsigned trainer,
+                 TrainerRun &run)
+{
+    vector<Member> party;
+    Pokemon encounter;
+
+    memset(&run, 0, sizeof(run));
+    run.starter = trainer % STARTER_COUNT;
+
+    int starter = searchDex(dex, STARTERS[run.starter]);
+    party.reserve(PARTY_SIZE + 1);
+    party.push_back(makeMember(dex, dex.pokedex[starter], starter,
+                               STARTER_LEVEL));
+
+    for (unsigned long r = 0; r < stages.size(); r++) {
+        RouteStage &stage = stages[r];
+        seed_seq seed = {PROGRESS_SEED, trainer, (unsigned)r};
+        stage.ctx.rng.seed(seed);
+
+        while (strongest(party) < stage.gate
+               and run.encounters[r] < ENCOUNTER_BUDGET) {
+            int level = spawn(stage.ctx, encounter);
+            run.encounters[r]++;
+
+            Member &fighter = party[bestMember(party, encounter,
+                                               stage.ctx.typeChart, known)];
+            if (not battle(stage.ctx, fighter.mon, encounter, NULL).firstWon)
+                continue;
+
+            run.catches[r]++;
+            gainExperience(dex, fighter, level);
+
+            int slot = stage.slots.find(encounter.name)->second;
+            int species = stage.dexIndex[slot];
+            const Pokemon &base = (species != -1) ? dex.pokedex[species]
+                                                  : stage.ctx.route[slot];
+            addToParty(party, makeMember(dex, base, species, level));
+        }
+
+        run.level[r] = partyLevel(party);
+        if (strongest(party) < stage.gate)
+            return;
+        run.cleared++;
+    }
+}
+
+/*
+ *  makeMember()
+ *
+ *  Parameters: context with loaded Pokédex, level 1 stats, Pokédex index
+ *              (-1 if none), level
+ *  Does:       Builds a party member with no experience yet, evolved as
+ *              far as its level allows, so a catch at or past its
+ *              evolution level joins as the evolved form.
+ *  Returns:    The member
+ */
+Member makeMember(const SimContext &dex, const Pokemon &base, int species,
+                  int level)
+{
+    Member member;
+
+    member.species = species;
+    member.base = base;
+    member.level = level;
+    member.xp = 0;
+    evolve(dex, member);
+
+    return member;
+}
+
+/*
+ *  bestMember()
+ *
+ *  Parameters: party, encountered Pokémon, type chart, odds known so far
+ *              by matchup class
+ *  Does:       Finds the party member with the highest probability of
+ *              beating the encounter. Ties (to within SETTLED) go to the
+ *              earlier member, unless a later one's matchup dominates.
+ *              Members are bounded first (see winBounds()), and those that
+ *              cannot beat the best lower bound, or whose matchup another
+ *              member's dominates, are skipped; the rest are solved
+ *              exactly. Each distinct hits-to-KO matchup is bounded and
+ *              solved at most once. One-sided matchups are settled by
+ *              their bounds, and most long ones (both sides dealing
+ *              minimum damage) by dominance.
+ *  Returns:    Index of the member in the party
+ */
+int bestMember(const vector<Member> &party, const Pokemon &encounter,
+               const vector< vector<int> > &typeChart,
+               unordered_map<long long, Odds> &known)
+{
+    MatchupClass matchups[PARTY_SIZE + 1];
+    Odds *odds[PARTY_SIZE + 1];
+    double bestLow = 0;
+    int best = 0;
+    double bestProb = -1;
+
+    for (unsigned long i = 0; i < party.size(); i++) {
+        const MatchupClass &matchup = matchups[i] =
+            classifyMatchup(party[i].mon, encounter, typeChart);
+        long long key = classKey(matchup);
+
+        auto found = known.find(key);
+        if (found == known.end()) {
+            Odds bounds;
+            winBounds(matchup, bounds.low, bounds.high);
+            bounds.solved = false;
+            bounds.exact = 0;
+            found = known.insert(make_pair(key, bounds)).first;
+        }
+        odds[i] = &found->second;
+        bestLow = max(bestLow, odds[i]->low);
+    }
+
+    for (unsigned long i = 0; i < party.size(); i++) {
+        if (odds[i]->high <= bestLow + SETTLED and odds[i]->low != bestLow)
+            continue;
+
+        bool dominated = false;
+        for (unsigned long j = 0; j < party.size() and not dominated; j++) {
+            dominated = j != i and dominates(matchups[j], matchups[i])
+                        and (j < i or not dominates(matchups[i], matchups[j]));
+        }
+        if (dominated)
+            continue;
+
+        // Which members are compared, and how, depends only on their
+        // bounds, never on what this thread happened to solve before
+        double prob = odds[i]->low;
+        if (odds[i]->high - odds[i]->low > SETTLED) {
+            if (not odds[i]->solved) {
+                odds[i]->exact = winProbability(matchups[i]);
+                odds[i]->solved = true;
+            }
+            prob = odds[i]->exact;
+        }
+
+        if (prob > bestProb) {
+            best = i;
+            bestProb = prob;
+        }
+    }
+
+    return best;
+}
+
+/*
+ *  dominates()
+ *
+ *  Parameters: two matchup classes
+ *  Does:       Checks whether the first is at least as good for the
+ *              attacker as the second whatever their exact odds: it needs
+ *              no more hits, the defender needs no fewer, and it moves
+ *              first if the second does. Dealing no damage is worst, and
+ *              taking none is best.
+ *  Returns:    True if the first class's win probability is at least the
+ *              second's
+ */
+bool dominates(const MatchupClass &a, const MatchupClass &b)
+{
+    if (b.atkHits == NO_KO)
+        return true;
+    if (a.atkHits == NO_KO or a.atkHits > b.atkHits)
+        return false;
+    if (a.defHits != NO_KO and (b.defHits == NO_KO or a.defHits < b.defHits))
+        return false;
+
+    return a.atkFirst or not b.atkFirst;
+}
+
+/*
+ *  gainExperience()
+ *
+ *  Parameters: context with loaded Pokédex, party member, experience
+ *              gained
+ *  Does:       Adds the experience and levels the member up while it has
+ *              enough (a level costs as much experience as the level being
+ *              left), up to MAX_LEVEL. Evolves it as the Pokédex says once
+ *              it reaches its evolution level (see evolve()).
+ *  Returns:    NA
+ */
+void gainExperience(const SimContext &dex, Member &member, int xp)
+{
+    member.xp += xp;
+    while (member.level < MAX_LEVEL and member.xp >= member.level) {
+        member.xp -= member.level;
+        member.level++;
+    }
+    if (member.level == MAX_LEVEL)
+        member.xp = 0;
+
+    evolve(dex, member);
+}
+
+/*
+ *  evolve()
+ *
+ *  Parameters: context with loaded Pokédex, party member
+ *  Does:       Follows the member's evolution chain as far as its level
+ *              allows (Eevee, whose evolution is the player's choice, stays
+ *              as it is), then updates its stats for its level.
+ *  Returns:    NA
+ */
+void evolve(const SimContext &dex, Member &member)
+{
+    int next = NO_EVOLUTION;
+    if (member.species != -1)
+        next = evolution(dex, member.species, member.level);
+
+    while (next >= 0) {
+        member.species = next;
+        member.base = dex.pokedex[next];
+        next = evolution(dex, next, member.level);
+    }
+
+    member.mon = levelStats(member.base, member.level);
+}
+
+/*
+ *  addToParty()
+ *
+ *  Parameters: party, caught Pokémon
+ *  Does:       Adds the caught Pokémon unless the party already has its
+ *              species. A full party swaps out its lowest-level member if
+ *              the caught Pokémon is higher level.
+ *  Returns:    NA
+ */
+void addToParty(vector<Member> &party, const Member &caught)
+{
+    int weakest = 0;
+
+    for (unsigned long i = 0; i < party.size(); i++) {
+        bool same = (caught.species != -1)
+                    ? party[i].species == caught.species
+                    : party[i].base.name == caught.base.name;
+        if (same)
+            return;
+        if (party[i].level < party[weakest].level)
+            weakest = i;
+    }
+
+    if (party.size() < (unsigned long)PARTY_SIZE)
+        party.push_back(caught);
+    else if (caught.level > party[weakest].level)
+        party[weakest] = caught;
+}
+
+/*
+ *  strongest()
+ *
+ *  Parameters: party
+ *  Does:       Finds the highest level in the party.
+ *  Returns:    The highest level
+ */
+int strongest(const vector<Member> &party)
+{
+    int level = 0;
+
+    for (unsigned long i = 0; i < party.size(); i++)
+        level = max(level, party[i].level);
+
+    return level;
+}
+
+/*
+ *  partyLevel()
+ *
+ *  Parameters: party
+ *  Does:       Averages the party's levels, rounding down.
+ *  Returns:    The mean level
+ */
+int partyLevel(const vector<Member> &party)
+{
+    int total = 0;
+
+    for (unsigned long i = 0; i < party.size(); i++)
+        total += party[i].level;
+
+    return total / party.size();
+}
+
+/*
+ *  reportProgress()
+ *
+ *  Parameters: stages, every trainer's run
+ *  Does:       Prints, per route, how many trainers reached it and stalled
+ *              on it, their mean encounters and win rate there, their mean
+ *              catches so far (the catch curve), and the 10th, 50th and
+ *              90th percentile of their party's mean level on leaving it
+ *              (the level curve; the strongest Pokémon leaves at the
+ *              gate). Then prints how many trainers completed the
+ *              progression, by starter, and the distribution of encounters
+ *              it took them.
+ *  Returns:    NA
+ */
+void reportProgress(const vector<RouteStage> &stages,
+                    const vector<TrainerRun> &runs)
+{
+    int count = stages.size();
+
+    cout << "\n" << left << setw(10) << "Route" << right << setw(6)
+         << "Gate" << setw(9) << "Reached" << setw(9) << "Stalled"
+         << setw(12) << "Encounters" << setw(8) << "Win %" << setw(10)
+         << "Catches" << "   Party LV. p10/p50/p90" << endl;
+
+    for (int r = 0; r < count; r++) {
+        vector<int> levels;
+        long encounters = 0, catches = 0, caughtSoFar = 0;
+        int stalled = 0;
+
+        for (unsigned long t = 0; t < runs.size(); t++) {
+            const TrainerRun &run = runs[t];
+            if (run.cleared < r)
+                continue;
+
+            levels.push_back(run.level[r]);
+            encounters += run.encounters[r];
+            catches += run.catches[r];
+            for (int i = 0; i <= r; i++)
+                caughtSoFar += run.catches[i];
+            if (run.cleared == r)
+                stalled++;
+        }
+
+        int reached = levels.size();
+        cout << left << setw(10) << stages[r].name << right << setw(6)
+             << stages[r].gate << setw(9) << reached << setw(9) << stalled
+             << fixed << setprecision(1);
+        if (reached == 0) {
+            cout << endl;
+            continue;
+        }
+        cout << setw(12) << (double)encounters / reached << setw(8)
+             << (encounters ? 100.0 * catches / encounters : 0.0)
+             << setw(10) << (double)caughtSoFar / reached << "   "
+             << percentile(levels, 0.1) << "/" << percentile(levels, 0.5)
+             << "/" << percentile(levels, 0.9) << endl;
+        cout.unsetf(ios::fixed);
+    }
+
+    vector<int> times;
+    int completed[STARTER_COUNT] = {0};
+    int started[STARTER_COUNT] = {0};
+
+    for (unsigned long t = 0; t < runs.size(); t++) {
+        const TrainerRun &run = runs[t];
+
+        started[run.starter]++;
+        if (run.cleared < count)
+            continue;
+
+        int total = 0;
+        for (int r = 0; r < count; r++)
+            total += run.encounters[r];
+        times.push_back(total);
+        completed[run.starter]++;
+    }
+
+    cout << "\nCompleted: " << times.size() << " of " << runs.size()
+         << " trainers (";
+    for (int s = 0; s < STARTER_COUNT; s++) {
+        cout << STARTERS[s] << " " << completed[s] << "/" << started[s]
+             << (s + 1 < STARTER_COUNT ? ", " : ")\n");
+    }
+
+    if (times.empty())
+        return;
+
+    cout << "Encounters to complete: p10 " << percentile(times, 0.1)
+         << ", median " << percentile(times, 0.5) << ", p90 "
+         << percentile(times, 0.9) << ", max " << percentile(times, 1.0)
+         << endl;
+}
+
+/*
+ *  percentile()
+ *
+ *  Parameters: values (not empty), fraction between 0 and 1
+ *  Does:       Finds the value at that fraction of the sorted values
+ *              (nearest rank).
+ *  Returns:    The percentile
+ */
+int percentile(vector<int> values, double fraction)
+{
+    unsigned long rank = (unsigned long)(fraction * (values.size() - 1) + 0.5);
+
+    nth_element(values.begin(), values.begin() + rank, values.end());
+
+    return values[rank];
+}
@@ -0,0 +1,261 @@
+/*
+ *      statindex.cpp
+ *
+ *      Purpose: Builds the k-d tree of rounded stats over every species and
+ *               level, and answers exact and nearest-neighbor queries on it
+ *               in logarithmic time.
+ *
+ *      Last modified: October 19, 2026
+ */
+
+#include <algorithm>
+
+#include "statindex.h"
+#include "pokesim.h"
+
+using namespace std;
+
+/*
+ * AxisLess
+ *
+ * Orders points by one stat, for partitioning around a median.
+ */
+struct AxisLess {
+    int axis;
+    bool operator()(const StatPoint &a, const StatPoint &b) const
+    {
+        return a.stats[axis] < b.stats[axis];
+    }
+};
+
+void buildRange(vector<StatPoint> &points, int low, int high, int depth);
+void exactRange(const vector<StatPoint> &points, int low, int high,
+                int depth, const int stats[], vector<StatMatch> &matches);
+void nearestRange(const vector<StatPoint> &points, int low, int high,
+                  int depth, const int stats[], unsigned count,
+                  vector<StatMatch> &matches);
+long distanceTo(const StatPoint &point, const int stats[]);
+bool closer(const StatMatch &a, const StatMatch &b);
+
+/*
+ *  buildStatIndex()
+ *
+ *  Parameters: index to build, Pokédex columns, highest level to index
+ *  Does:       Computes every species' stats at levels 1 to maxLevel,
+ *              rounded with roundStat() exactly as stats prints them, and
+ *              arranges them into a k-d tree. A species that evolves is
+ *              indexed only below its evolution level; from then on it is
+ *              its evolved form, which is indexed as its own species.
+ *  Returns:    NA
+ */
+void buildStatIndex(StatIndex &tree, const DexColumns &columns, int maxLevel)
+{
+    unsigned long count = columns.HP.size();
+
+    tree.points.clear();
+    tree.points.reserve(count * maxLevel);
+
+    for (unsigned long i = 0; i < count; i++) {
+        int last = maxLevel;
+        if (columns.nextEvol[i] != 0)
+            last = min(last, columns.nextEvol[i] - 1);
+
+        for (int level = 1; level <= last; level++) {
+            StatPoint point;
+
+            point.stats[0] = roundStat(columns.HP[i] * level);
+            point.stats[1] = roundStat(columns.attack[i] * level);
+            point.stats[2] = roundStat(columns.defense[i] * level);
+            point.stats[3] = roundStat(columns.speed[i] * level);
+            point.index = i;
+            point.level = level;
+            tree.points.push_back(point);
+        }
+    }
+
+    buildRange(tree.points, 0, tree.points.size(), 0);
+}
+
+/*
+ *  findExact()
+ *
+ *  Parameters: stat index, HP, attack, defense, and speed to look up,
+ *              matches to populate
+ *  Does:       Finds every species and level with exactly these stats.
+ *              Points equal to a median on its axis can sit on either side
+ *              of it, so equal stats descend both ways.
+ *  Returns:    NA
+ */
+void findExact(const StatIndex &tree, const int stats[],
+               vector<StatMatch> &matches)
+{
+    matches.clear();
+    exactRange(tree.points, 0, tree.points.size(), 0, stats, matches);
+    sort(matches.begin(), matches.end(), closer);
+}
+
+/*
+ *  findNearest()
+ *
+ *  Parameters: stat index, HP, attack, defense, and speed to look up,
+ *              number of matches wanted, matches to populate
+ *  Does:       Finds the species and levels whose stats are closest
+ *              (Euclidean distance) to these, skipping subtrees that cannot
+ *              beat the furthest match kept so far.
+ *  Returns:    NA
+ */
+void findNearest(const StatIndex &tree, const int stats[], int count,
+                 vector<StatMatch> &matches)
+{
+    matches.clear();
+    if (count <= 0)
+        return;
+
+    nearestRange(tree.points, 0, tree.points.size(), 0, stats, count,
+                 matches);
+    sort(matches.begin(), matches.end(), closer);
+}
+
+/*
+ *  buildRange()
+ *
+ *  Parameters: points, range of points to arrange [low, high), depth
+ *  Does:       Moves the range's median on stat (depth % STAT_DIMS) to its
+ *              middle, then arranges each half one level deeper.
+ *  Returns:    NA
+ */
+void buildRange(vector<StatPoint> &points, int low, int high, int depth)
+{
+    if (high - low <= 1)
+        return;
+
+    int mid = low + (high - low) / 2;
+    AxisLess less;
+    less.axis = depth % STAT_DIMS;
+
+    nth_element(points.begin() + low, points.begin() + mid,
+                points.begin() + high, less);
+
+    buildRange(points, low, mid, depth + 1);
+    buildRange(points, mid + 1, high, depth + 1);
+}
+
+/*
+ *  exactRange()
+ *
+ *  Parameters: points, range of points to search [low, high), depth,
+ *              stats to look up, matches to append to
+ *  Does:       Appends every point in the range with exactly these stats.
+ *  Returns:    NA
+ */
+void exactRange(const vector<StatPoint> &points, int low, int high,
+                int depth, const int stats[], vector<StatMatch> &matches)
+{
+    if (high <= low)
+        return;
+
+    int mid = low + (high - low) / 2;
+    int axis = depth % STAT_DIMS;
+    const StatPoint &point = points[mid];
+
+    if (distanceTo(point, stats) == 0) {
+        StatMatch match;
+        match.index = point.index;
+        match.level = point.level;
+        match.distance = 0;
+        matches.push_back(match);
+    }
+
+    if (stats[axis] <= point.stats[axis])
+        exactRange(points, low, mid, depth + 1, stats, matches);
+    if (stats[axis] >= point.stats[axis])
+        exactRange(points, mid + 1, high, depth + 1, stats, matches);
+}
+
+/*
+ *  nearestRange()
+ *
+ *  Parameters: points, range of points to search [low, high), depth,
+ *              stats to look up, number of matches wanted, matches kept so
+ *              far (a max-heap on distance)
+ *  Does:       Offers the range's median to the matches, searches the half
+ *              the stats fall in, then the other half only if its splitting
+ *              plane is no further than the furthest match kept.
+ *  Returns:    NA
+ */
+void nearestRange(const vector<StatPoint> &points, int low, int high,
+                  int depth, const int stats[], unsigned count,
+                  vector<StatMatch> &matches)
+{
+    if (high <= low)
+        return;
+
+    int mid = low + (high - low) / 2;
+    int axis = depth % STAT_DIMS;
+    const StatPoint &point = points[mid];
+
+    StatMatch match;
+    match.index = point.index;
+    match.level = point.level;
+    match.distance = distanceTo(point, stats);
+
+    if (matches.size() < count) {
+        matches.push_back(match);
+        push_heap(matches.begin(), matches.end(), closer);
+    } else if (closer(match, matches.front())) {
+        pop_heap(matches.begin(), matches.end(), closer);
+        matches.back() = match;
+        push_heap(matches.begin(), matches.end(), closer);
+    }
+
+    long gap = (long)stats[axis] - point.stats[axis];
+    bool lowFirst = gap <= 0;
+
+    if (lowFirst)
+        nearestRange(points, low, mid, depth + 1, stats, count, matches);
+    else
+        nearestRange(points, mid + 1, high, depth + 1, stats, count, matches);
+
+    if (matches.size() < count or gap * gap <= matches.front().distance) {
+        if (lowFirst)
+            nearestRange(points, mid + 1, high, depth + 1, stats, count,
+                         matches);
+        else
+            nearestRange(points, low, mid, depth + 1, stats, count, matches);
+    }
+}
+
+/*
+ *  distanceTo()
+ *
+ *  Parameters: indexed point, stats to compare with
+ *  Does:       Computes the squared Euclidean distance between the two.
+ *  Returns:    Squared distance
+ */
+long distanceTo(const StatPoint &point, const int stats[])
+{
+    long distance = 0;
+
+    for (int i = 0; i < STAT_DIMS; i++) {
+        long gap = (long)stats[i] - point.stats[i];
+        distance += gap * gap;
+    }
+
+    return distance;
+}
+
+/*
+ *  closer()
+ *
+ *  Parameters: two matches
+ *  Does:       Orders matches by distance, then Pokédex index, then level.
+ *  Returns:    True if a comes before b
+ */
+bool closer(const StatMatch &a, const StatMatch &b)
+{
+    if (a.distance != b.distance)
+        return a.distance < b.distance;
+    if (a.index != b.index)
+        return a.index < b.index;
+    return a.level < b.level;
+}
@@ -0,0 +1,64 @@
+/*
+ *      statindex.h
+ *
+ *      Purpose: Reverse stat lookup. Indexes the rounded stats (as stats
+ *               reports them) of every species at every level it reaches
+ *               before evolving in a 4-D k-d tree, so observed HP, attack,
+ *               defense, and speed can be traced back to the species and
+ *               levels that have them, or the nearest ones if none match
+ *               exactly.
+ *
+ *      Last modified: October 19, 2026
+ */
+
+#ifndef STATINDEX_H
+#define STATINDEX_H
+
+#include <vector>
+
+#include "compactdex.h"
+
+const int STAT_DIMS = 4;
+
+/*
+ * StatPoint
+ *
+ * One species at one level: its rounded HP, attack, defense, and speed,
+ * Pokédex index, and level.
+ */
+struct StatPoint {
+    int stats[STAT_DIMS];
+    int index;
+    int level;
+};
+
+/*
+ * StatMatch
+ *
+ * A species and level found for a query, and its squared distance from
+ * the queried stats (0 for exact matches).
+ */
+struct StatMatch {
+    int index;
+    int level;
+    long distance;
+};
+
+/*
+ * StatIndex
+ *
+ * Implicit k-d tree: the median of each range of points is at its middle,
+ * split on stat (depth % STAT_DIMS), with smaller stats before it and
+ * larger after. Needs no pointers or allocations beyond the point array.
+ */
+struct StatIndex {
+    std::vector<StatPoint> points;
+};
+
+void buildStatIndex(StatIndex &tree, const DexColumns &columns, int maxLevel);
+void findExact(const StatIndex &tree, const int stats[],
+               std::vector<StatMatch> &matches);
+void findNearest(const StatIndex &tree, const int stats[], int count,
+                 std::vector<StatMatch> &matches);
+
+#endif
@@ -5,217 +5,482 @@
  *      Purpose: Calculates a pokemon's stats (HP, attack, defense, speed) at
  *               a given level. If the level corresponds to the given
  *               Pokemon's next evolution, then reports the evolution's stats.
+ *               Stats and evolutions are computed by libpokesim. The counter
+ *               subcommand instead ranks every species, at a given level, by
+ *               how reliably it beats a given opponent, the identify
+ *               subcommand works out species and level from observed stats,
+ *               and the query subcommand filters and sorts the Pokédex.
  *
- *      Last modified: May 30, 2020
+ *      Last modified: October 19, 2026
  */
 
 #include <iostream>
-#include <fstream>
-#include <sstream>
+#include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <cstdlib>
+#include <thread>
 #include <vector>
 
+#include "pokesim.h"
+#include "statindex.h"
+#include "dexquery.h"
+
 using namespace std;
 
+const int MAX_LEVEL = 100;
+const int DEFAULT_COUNTERS = 10;
+const int DEFAULT_NEAREST = 3;
+/* Largest observed stat identify accepts, so the squared distances of all
+ * four stats fit a long. */
+const int MAX_OBSERVED = 1000000;
+/* Slack for rounding between winBounds() and winProbability(): a candidate
+ * is only pruned if its upper bound is below the cut-off by more than
+ * this, so one that could tie is always solved. */
+const double RANK_TOLERANCE = 1e-9;
+
 /*
- * Pokémon
+ * Counter
  *
- * Describes a single Pokémon: its name, type, stats (speed, attack, defense,
- * HP), and level of next evolution.
+ * A candidate counter: its Pokédex index, its matchup class against the
+ * opponent, bounds on its win probability, and its exact win probability
+ * once solved.
  */
-struct Pokemon {
-    string name;
-    double HP;
-    double attack;
-    double defense;
-    double speed;
-    string type;
-    int nextEvol;
+struct Counter {
+    int index;
+    MatchupClass matchup;
+    double low;
+    double high;
+    double winProb;
 };
 
-vector<Pokemon> populateDex(string file, vector<Pokemon> pokedex);
-Pokemon calculateStats(string name, double maxHP, double maxAtk, double maxDef,
-                       double spAtk, double spDef, double maxSpd, string type,
-                       int nextEvol);
-int searchDex(string pokemon, vector<Pokemon> pokedex);
-void generateStats(int level, int index, vector<Pokemon> pokedex, bool first);
-void baseStats(int index, vector<Pokemon> pokedex);
+void generateStats(const SimContext &ctx, int level, int index, bool first);
+void baseStats(const SimContext &ctx, int index);
+int findCounters(const SimContext &ctx, int opponent, int level,
+                 int candidateLevel, int count);
+void solveCounters(vector<Counter> &counters, unsigned long first,
+                   unsigned long last, unsigned step);
+void identify(const SimContext &ctx, int count);
+int queryDex(const SimContext &ctx, const vector<string> &terms);
+bool byHigh(const Counter &a, const Counter &b);
+bool byWinProb(const Counter &a, const Counter &b);
 
 int main(int argc, char* argv[])
 {
+    if (argc >= 3 and string(argv[2]) == "counter") {
+        if (argc != 6 and argc != 7) {
+            cout << "Usage: ./stats [pokedex] counter [opponent] [level] "
+                 << "[candidate level] [count]" << endl;
+            return 1;
+        }
+
+        SimContext ctx;
+        string error;
+        initContext(ctx, 0);
+        if (not populateDex(ctx, argv[1], error)) {
+            cerr << argv[1] << ": " << error << "." << endl;
+            return 1;
+        }
+
+        int opponent = searchDex(ctx, argv[3]);
+        if (opponent == -1) {
+            cout << "Pokemon not found." << endl;
+            return 1;
+        }
+
+        int count = (argc == 7) ? atoi(argv[6]) : DEFAULT_COUNTERS;
+        return findCounters(ctx, opponent, atoi(argv[4]), atoi(argv[5]),
+                            count);
+    }
+
+    if (argc >= 3 and string(argv[2]) == "identify") {
+        if (argc != 3 and argc != 4) {
+            cout << "Usage: ./stats [pokedex] identify [count]" << endl;
+            return 1;
+        }
+
+        SimContext ctx;
+        string error;
+        initContext(ctx, 0);
+        if (not populateDex(ctx, argv[1], error)) {
+            cerr << argv[1] << ": " << error << "." << endl;
+            return 1;
+        }
+
+        identify(ctx, (argc == 4) ? atoi(argv[3]) : DEFAULT_NEAREST);
+        return 0;
+    }
+
+    if (argc >= 3 and string(argv[2]) == "query") {
+        SimContext ctx;
+        string error;
+        initContext(ctx, 0);
+        if (not populateDex(ctx, argv[1], error)) {
+            cerr << argv[1] << ": " << error << "." << endl;
+            return 1;
+        }
+
+        return queryDex(ctx, vector<string>(argv + 3, argv + argc));
+    }
+
     if (argc != 2)
         cout << "Usage: ./stats [pokedex]" << endl;
     else {
-        vector<Pokemon> pokedex;
+        SimContext ctx;
         string file = argv[1];
-        string pokemon;
+        string pokemon, error;
         int level;
 
         // Populates Pokédex
-        pokedex = populateDex(file, pokedex);
+        initContext(ctx, 0);
+        if (not populateDex(ctx, file, error)) {
+            cerr << file << ": " << error << "." << endl;
+            return 1;
+        }
         
         cout << "Enter pokemon's name and level: ";
         cin >> pokemon >> level;
 
-        int index = searchDex(pokemon, pokedex);
+        int index = searchDex(ctx, pokemon);
 
-        if (index == -1)
+        if (index == -1) {
+            cout << "Pokemon not found." << endl;
             exit(1);
-        else if (level == 1)
-            baseStats(index, pokedex);
+        } else if (level == 1)
+            baseStats(ctx, index);
         else
-            generateStats(level, index, pokedex, true);
+            generateStats(ctx, level, index, true);
             // Generates & prints stats
     }
 }
 
 /*
- *  populateDex()
+ *  generateStats()
  *
- *  Parameters: name of pokedex file, empty vector of pokedex Pokémon
- *  Does:       Populates the Pokédex vector with information from file
- *              regarding each Pokémon's name, HP, attack, defense, and speed.
- *  Returns:    Filled Pokédex
+ *  Parameters: context, user-specified Pokémon level, index of Pokédex
+ *              Pokémon is found at, true unless reporting an evolution
+ *  Does:       Calculates stats based on user's specified level and rounds
+ *              (halves up, in exact integer arithmetic).
+ *              Prints HP, attack, defense, and speed stats.
+ *  Returns:    NA
  */
-vector<Pokemon> populateDex(string file, vector<Pokemon> pokedex)
+void generateStats(const SimContext &ctx, int level, int index, bool first)
 {
-    ifstream input;
-    string info;
+    const Pokemon &mon = ctx.pokedex[index];
+    Pokemon stats = levelStats(mon, level);
+    int HP, attack, defense, speed;
 
-    input.open(file);
+    HP = roundStat(stats.HP);
+    attack = roundStat(stats.attack);
+    defense = roundStat(stats.defense);
+    speed = roundStat(stats.speed);
 
-    string name, type;
-    int nextEvol;
-    double maxHP, maxAtk, maxDef, spAtk, spDef, maxSpd;
+    int evolved = evolution(ctx, index, level);
 
-    while (getline(input, info)) {
-        istringstream ss(info);
+    /* If provided level corresponds to the Pokémon's next evolution,
+     * generate stats of the evolution. */
+    if (evolved != NO_EVOLUTION and first == true) {
+        
+        /* Eevee is a special Pokémon that has 9 different evolutions, each with
+         * different stats. Requires user to pick evolution before continuing. */
+        if (evolved == EVOLUTION_CHOICE) {
+            cout << "*** EEVEE IS EVOLVING. PICK EVOLUTION. ***" << endl;
+        } else {
+            string evolution = ctx.pokedex[evolved].name;
+            cout << "\n*** " << mon.name << " IS EVOLVING INTO "
+                 << evolution << "! ***\n";
 
-        ss >> name >> maxHP >> maxAtk >> maxDef >> spAtk >> spDef >> maxSpd
-           >> type >> nextEvol;
+            generateStats(ctx, level, evolved, false);
+        }
+    } else {
+        cout << "\n------ " << mon.name << "'s STATS ------\n" << endl;
 
-        Pokemon entry;
-        entry = calculateStats(name, maxHP, maxAtk, maxDef, spAtk, spDef, maxSpd, type, nextEvol);
+        cout << "HP: " << HP << endl;
+        cout << "Attack: " << attack << endl;
+        cout << "Defense: " << defense << endl;
+        cout << "Speed: " << speed << endl;
+        cout << "Type: " << mon.type << endl;
 
-        pokedex.push_back(entry);
+        if (mon.nextEvol == 0)
+            cout << "CANNOT EVOLVE." << endl;
+        else
+            cout << "EVOLVES AT: " << mon.nextEvol << endl; 
     }
-
-    return pokedex;
 }
 
 /*
- *  calculateStats()
+ *  baseStats()
  *
- *  Parameters: Pokémon's name, type maximum HP, attack, defense, special
- *              attack, special defense, and speed stats.
- *  Does:       Divides max stat values by 100 and populates entry struct.
- *  Returns:    A Pokémon struct with respective stats populated.
+ *  Parameters: context, index of Pokédex Pokémon is found at
+ *  Does:       Prints the Pokémon's base stats (at Level 1)
+ *  Returns:    NA
  */
-Pokemon calculateStats(string name, double maxHP, double maxAtk, double maxDef, double spAtk,
-                       double spDef, double maxSpd, string type, int nextEvol)
+void baseStats(const SimContext &ctx, int index)
 {
-    Pokemon entry;
-
-    entry.name = name;
-    entry.HP = maxHP / 100;
-    entry.attack = ((maxAtk + spAtk) / 2) / 100;
-    entry.defense = ((maxDef + spDef) / 2) / 100;
-    entry.speed = maxSpd / 100;
-    entry.type = type;
-    entry.nextEvol = nextEvol;
+    const Pokemon &mon = ctx.pokedex[index];
 
-    return entry;
+    cout << "HP: " << fromFixed(mon.HP, STAT_SCALE) << endl;
+    cout << "Attack: " << fromFixed(mon.attack, STAT_SCALE) << endl;
+    cout << "Defense: " << fromFixed(mon.defense, STAT_SCALE) << endl;
+    cout << "Speed: " << fromFixed(mon.speed, STAT_SCALE) << endl;
+    cout << "Type: " << mon.type << endl;
 }
 
 /*
- *  searchDex()
+ *  findCounters()
  *
- *  Parameters: name of Pokémon, pokedex vector
- *  Does:       Searches through the Pokédex for the specific Pokémon. If
- *              found, returns index within vector the Pokémon is found at,
- *              otherwise returns -1.
- *  Returns:    Index with which specific Pokémon is found at, otherwise -1
+ *  Parameters: context, Pokédex index of opponent and its level, level of
+ *              candidate counters, number of counters to report
+ *  Does:       Ranks every species at the candidate level by its exact
+ *              probability of beating the opponent, solving as few matchups
+ *              as possible. Every candidate is first classified from its
+ *              compact record and bounded with winBounds(); candidates whose
+ *              upper bound is below the count-th best lower bound (by more
+ *              than RANK_TOLERANCE) cannot place and are pruned. The rest
+ *              are solved in parallel, a round of one per thread at a time,
+ *              in order of upper bound, until the next upper bound is below
+ *              the count-th best solved candidate by more than
+ *              RANK_TOLERANCE. A candidate that could still tie the cut-off
+ *              is therefore solved, and ties go to the lower Pokédex index.
+ *              Prints the top counters and how many candidates were pruned.
+ *  Returns:    0 on success, 1 if the levels or count are out of range
  */
-int searchDex(string pokemon, vector<Pokemon> pokedex)
+int findCounters(const SimContext &ctx, int opponent, int level,
+                 int candidateLevel, int count)
 {
-    int index = -1;
-    bool found = false;
+    if (level < 1 or level > MAX_LEVEL or candidateLevel < 1
+        or candidateLevel > MAX_LEVEL or count < 1) {
+        cout << "Levels must be 1 - 100 and count at least 1." << endl;
+        return 1;
+    }
 
-    for (unsigned long i = 0; i < pokedex.size(); i++) {
-        if (pokedex[i].name == pokemon) {
-            index = i;
-            found = true;
-        }
+    MonRecord defender = makeRecord(ctx.columns, opponent, level);
+    vector<Counter> counters(ctx.pokedex.size());
+    vector<double> lows;
+
+    for (unsigned long i = 0; i < counters.size(); i++) {
+        Counter &counter = counters[i];
+
+        counter.index = i;
+        counter.matchup = classifyRecords(makeRecord(ctx.columns, i,
+                                                     candidateLevel),
+                                          defender, ctx.typeChart);
+        winBounds(counter.matchup, counter.low, counter.high);
+        counter.winProb = -1;
+        lows.push_back(counter.low);
     }
 
-    if (not found)
-        cout << "Pokemon not found." << endl;
+    if (count > (int)counters.size())
+        count = counters.size();
+
+    // Some count candidates are certain to do at least this well
+    nth_element(lows.begin(), lows.begin() + count - 1, lows.end(),
+                greater<double>());
+    double floor = lows[count - 1];
+
+    sort(counters.begin(), counters.end(), byHigh);
+    unsigned long live = 0;
+    while (live < counters.size()
+           and counters[live].high + RANK_TOLERANCE >= floor)
+        live++;
+
+    unsigned workers = thread::hardware_concurrency();
+    if (workers == 0)
+        workers = 1;
+
+    vector<double> best;
+    unsigned long solved = 0;
+
+    while (solved < live) {
+        // Stops only once no unsolved candidate could tie the cut-off
+        if ((int)best.size() >= count
+            and counters[solved].high + RANK_TOLERANCE < best[count - 1])
+            break;
 
-    return index;
+        unsigned long last = min(live, solved + workers);
+        vector<thread> pool;
+        for (unsigned i = 1; i < last - solved; i++)
+            pool.push_back(thread(solveCounters, ref(counters), solved + i,
+                                  last, workers));
+        solveCounters(counters, solved, last, workers);
+        for (unsigned long i = 0; i < pool.size(); i++)
+            pool[i].join();
+
+        for (unsigned long i = solved; i < last; i++)
+            best.push_back(counters[i].winProb);
+        sort(best.begin(), best.end(), greater<double>());
+        solved = last;
+    }
+
+    sort(counters.begin(), counters.begin() + solved, byWinProb);
+
+    const Pokemon &mon = ctx.pokedex[opponent];
+    cout << "------ BEST LV. " << candidateLevel << " COUNTERS TO LV. "
+         << level << " " << mon.name << " ------\n" << endl;
+
+    for (int i = 0; i < count and i < (int)solved; i++) {
+        cout << i + 1 << ". " << ctx.pokedex[counters[i].index].name
+             << ": wins " << round(counters[i].winProb * 10000) / 100 << "%"
+             << endl;
+    }
+
+    cout << "\nSolved " << solved << " of " << counters.size()
+         << " candidates; pruned " << counters.size() - solved
+         << " by bounds (" << counters.size() - live
+         << " before solving any)." << endl;
+
+    return 0;
 }
 
 /*
- *  generateStats()
+ *  identify()
  *
- *  Parameters: user-specified Pokémon level, index of Pokédex Pokémon is
- *              found at, Pokédex vector
- *  Does:       Calculates stats based on user's specified level and rounds.
- *              Prints HP, attack, defense, and speed stats.
+ *  Parameters: context, number of nearest matches to report
+ *  Does:       Indexes every species' stats at every level, rounded as
+ *              generateStats() rounds them, then repeatedly prompts for
+ *              observed HP, attack, defense, and speed (each 0 -
+ *              MAX_OBSERVED) until input ends. Reports every species and
+ *              level with exactly those stats, or if there are none, the
+ *              nearest ones and how far off they are.
  *  Returns:    NA
  */
-void generateStats(int level, int index, vector<Pokemon> pokedex, bool first)
+void identify(const SimContext &ctx, int count)
 {
-    int HP, attack, defense, speed;
+    StatIndex tree;
+    vector<StatMatch> matches;
+    int stats[STAT_DIMS];
 
-    HP = round(pokedex[index].HP * level);
-    attack = round(pokedex[index].attack * level);
-    defense = round(pokedex[index].defense * level);
-    speed = round(pokedex[index].speed * level);
+    buildStatIndex(tree, ctx.columns, MAX_LEVEL);
 
-    /* If provided level corresponds to the Pokémon's next evolution,
-     * generate stats of the evolution. */
-    if (level >= pokedex[index].nextEvol and pokedex[index].nextEvol != 0
-        and first == true) {
-        
-        /* Eevee is a special Pokémon that has 9 different evolutions, each with
-         * different stats. Requires user to pick evolution before continuing. */
-        if (pokedex[index].name == "eevee") {
-            cout << "*** EEVEE IS EVOLVING. PICK EVOLUTION. ***" << endl;
+    while (true) {
+        cout << "Enter observed HP, attack, defense, and speed: ";
+        if (not (cin >> stats[0] >> stats[1] >> stats[2] >> stats[3]))
+            break;
+
+        bool valid = true;
+        for (int i = 0; i < STAT_DIMS; i++)
+            valid = valid and stats[i] >= 0 and stats[i] <= MAX_OBSERVED;
+        if (not valid) {
+            cout << "\nStats must be 0 - " << MAX_OBSERVED << ".\n" << endl;
+            continue;
+        }
+
+        findExact(tree, stats, matches);
+        if (matches.empty()) {
+            cout << "\nNo exact match. Nearest:" << endl;
+            findNearest(tree, stats, count, matches);
         } else {
-            string evolution = pokedex[index + 1].name;
-            cout << "\n*** " << pokedex[index].name << " IS EVOLVING INTO "
-                 << evolution << "! ***\n";
+            cout << "\nExact matches:" << endl;
+        }
 
-            generateStats(level, index + 1, pokedex, false);
+        for (unsigned long i = 0; i < matches.size(); i++) {
+            cout << ctx.pokedex[matches[i].index].name << " LV. "
+                 << matches[i].level;
+            if (matches[i].distance > 0)
+                cout << " (off by " << sqrt((double)matches[i].distance)
+                     << ")";
+            cout << endl;
         }
-    } else {
-        cout << "\n------ " << pokedex[index].name << "'s STATS ------\n" << endl;
+        cout << endl;
+    }
+    cout << endl;
+}
 
-        cout << "HP: " << HP << endl;
-        cout << "Attack: " << attack << endl;
-        cout << "Defense: " << defense << endl;
-        cout << "Speed: " << speed << endl;
-        cout << "Type: " << pokedex[index].type << endl;
+/*
+ *  queryDex()
+ *
+ *  Parameters: context, query terms (see parseQuery())
+ *  Does:       Indexes the Pokédex columns, runs the query, and prints the
+ *              matching species with their stats at the query's level,
+ *              rounded as generateStats() rounds them, the total number of
+ *              matches, and how long finding and counting them took
+ *              (excluding building the index).
+ *  Returns:    0 on success, 1 if the query does not parse
+ */
+int queryDex(const SimContext &ctx, const vector<string> &terms)
+{
+    DexIndex index;
+    DexQuery query;
+    vector<uint32_t> rows;
+    string error;
 
-        if (pokedex[index].nextEvol == 0)
-            cout << "CANNOT EVOLVE." << endl;
+    if (not parseQuery(terms, query, error)) {
+        cout << "Bad query: " << error << "." << endl;
+        return 1;
+    }
+
+    buildDexIndex(index, ctx.columns);
+
+    auto start = chrono::steady_clock::now();
+    runQuery(index, ctx.columns, query, rows);
+    chrono::duration<double, micro> found = chrono::steady_clock::now()
+                                            - start;
+
+    start = chrono::steady_clock::now();
+    unsigned long matches = countQuery(index, ctx.columns, query);
+    chrono::duration<double, micro> counted = chrono::steady_clock::now()
+                                              - start;
+
+    cout << "------ " << matches << " MATCHES AT LV. " << query.level
+         << " ------\n" << endl;
+
+    for (unsigned long i = 0; i < rows.size(); i++) {
+        Pokemon mon = levelStats(ctx.pokedex[rows[i]], query.level);
+
+        cout << i + 1 << ". " << mon.name << " (" << mon.type << ") HP: "
+             << roundStat(mon.HP) << ", Attack: " << roundStat(mon.attack)
+             << ", Defense: " << roundStat(mon.defense) << ", Speed: "
+             << roundStat(mon.speed);
+        if (mon.nextEvol == 0)
+            cout << ", cannot evolve" << endl;
         else
-            cout << "EVOLVES AT: " << pokedex[index].nextEvol << endl; 
+            cout << ", evolves at " << mon.nextEvol << endl;
     }
+
+    cout << "\nShowing " << rows.size() << " of " << matches << " (found in "
+         << found.count() << " µs, counted in " << counted.count()
+         << " µs)." << endl;
+
+    return 0;
 }
 
 /*
- *  baseStats()
+ *  solveCounters()
  *
- *  Parameters: index of Pokédex Pokémon is found at, Pokédex vector
- *  Does:       Prints the Pokémon's base stats (at Level 1)
+ *  Parameters: candidate counters, first candidate to solve, end of the
+ *              round, stride between candidates
+ *  Does:       Computes the exact win probability of every step-th
+ *              candidate in the round.
  *  Returns:    NA
  */
-void baseStats(int index, vector<Pokemon> pokedex)
+void solveCounters(vector<Counter> &counters, unsigned long first,
+                   unsigned long last, unsigned step)
+{
+    for (unsigned long i = first; i < last; i += step)
+        counters[i].winProb = winProbability(counters[i].matchup);
+}
+
+/*
+ *  byHigh(), byWinProb()
+ *
+ *  Parameters: two candidate counters
+ *  Does:       Orders candidates by upper bound (then lower bound), or by
+ *              exact win probability, best first; ties go to the lower
+ *              Pokédex index.
+ *  Returns:    True if a comes before b
+ */
+bool byHigh(const Counter &a, const Counter &b)
+{
+    if (a.high != b.high)
+        return a.high > b.high;
+    if (a.low != b.low)
+        return a.low > b.low;
+    return a.index < b.index;
+}
+
+bool byWinProb(const Counter &a, const Counter &b)
 {
-    cout << "HP: " << pokedex[index].HP << endl;
-    cout << "Attack: " << pokedex[index].attack << endl;
-    cout << "Defense: " << pokedex[index].defense << endl;
-    cout << "Speed: " << pokedex[index].speed << endl;
-    cout << "Type: " << pokedex[index].type << endl;
+    if (a.winProb != b.winProb)
+        return a.winProb > b.winProb;
+    return a.index < b.index;
 }
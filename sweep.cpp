@@ -0,0 +1,176 @@
+/*
+ *      sweep.cpp
+ *
+ *      Purpose: Computes the win probability of one Pokémon against another
+ *               for every pair of levels from 1 to 100 and writes the grid
+ *               as CSV, ready to plot as a heatmap. Neighbouring cells often
+ *               reduce to the same hits-to-KO matchup, so each distinct
+ *               matchup is solved once (in parallel) and reused.
+ *
+ *      Last modified: October 19, 2026
+ */
+
+#include <iostream>
+#include <fstream>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "pokesim.h"
+
+using namespace std;
+
+const int MAX_LEVEL = 100;
+
+void solveClasses(const vector<MatchupClass> &classes, vector<double> &probs,
+                  unsigned first, unsigned step);
+void sweep(const Pokemon &monA, const Pokemon &monB,
+           const vector< vector<int> > &typeChart, vector<double> &grid);
+void writeGrid(ostream &out, const vector<double> &grid);
+
+int main(int argc, char* argv[])
+{
+    if (argc != 4 and argc != 5) {
+        cout << "Usage: ./sweep [pokedex] [pokemon A] [pokemon B] [output.csv]"
+             << endl;
+        return 1;
+    }
+
+    SimContext ctx;
+    string error;
+
+    initContext(ctx, 0);
+    if (not populateDex(ctx, argv[1], error)) {
+        cerr << argv[1] << ": " << error << "." << endl;
+        return 1;
+    }
+
+    for (int i = 2; i <= 3; i++) {
+        if (searchDex(ctx, argv[i]) == -1) {
+            cerr << argv[i] << ": Pokémon not found." << endl;
+            return 1;
+        }
+    }
+
+    // Opens the output first, so a bad path fails before the sweep runs
+    ofstream output;
+    if (argc == 5) {
+        output.open(argv[4]);
+        if (not output.is_open()) {
+            cerr << argv[4] << ": cannot write." << endl;
+            return 1;
+        }
+    }
+
+    vector<double> grid;
+    sweep(ctx.pokedex[searchDex(ctx, argv[2])],
+          ctx.pokedex[searchDex(ctx, argv[3])], ctx.typeChart, grid);
+
+    ostream &out = (argc == 5) ? output : cout;
+    writeGrid(out, grid);
+    out.flush();
+    if (not out) {
+        cerr << ((argc == 5) ? argv[4] : "output") << ": cannot write."
+             << endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+/*
+ *  sweep()
+ *
+ *  Parameters: base stats of Pokémon A and B, type chart, grid to fill
+ *  Does:       Classifies every (level A, level B) cell by its hits-to-KO
+ *              matchup, solves each distinct class once across all cores,
+ *              and fills the grid (row = level A, column = level B) with A's
+ *              win probability. Reports how many cells were reused.
+ *  Returns:    NA
+ */
+void sweep(const Pokemon &monA, const Pokemon &monB,
+           const vector< vector<int> > &typeChart, vector<double> &grid)
+{
+    vector<MatchupClass> classes;
+    vector<int> cellClass(MAX_LEVEL * MAX_LEVEL);
+    unordered_map<long long, int> seen;
+
+    for (int levelA = 1; levelA <= MAX_LEVEL; levelA++) {
+        Pokemon attacker = levelStats(monA, levelA);
+
+        for (int levelB = 1; levelB <= MAX_LEVEL; levelB++) {
+            MatchupClass matchup = classifyMatchup(attacker,
+                                                   levelStats(monB, levelB),
+                                                   typeChart);
+            long long key = classKey(matchup);
+
+            auto found = seen.find(key);
+            if (found == seen.end()) {
+                found = seen.insert(make_pair(key, (int)classes.size())).first;
+                classes.push_back(matchup);
+            }
+            cellClass[(levelA - 1) * MAX_LEVEL + (levelB - 1)] = found->second;
+        }
+    }
+
+    // Solves distinct classes on every core, interleaved so the expensive
+    // (high hits-to-KO) classes are spread evenly
+    vector<double> probs(classes.size());
+    unsigned workers = thread::hardware_concurrency();
+    if (workers == 0)
+        workers = 1;
+
+    vector<thread> pool;
+    for (unsigned i = 1; i < workers; i++)
+        pool.push_back(thread(solveClasses, cref(classes), ref(probs), i,
+                              workers));
+    solveClasses(classes, probs, 0, workers);
+    for (unsigned long i = 0; i < pool.size(); i++)
+        pool[i].join();
+
+    grid.resize(cellClass.size());
+    for (unsigned long i = 0; i < cellClass.size(); i++)
+        grid[i] = probs[cellClass[i]];
+
+    cerr << monA.name << " vs " << monB.name << ": " << grid.size()
+         << " cells, " << classes.size() << " distinct matchups solved on "
+         << workers << " thread(s)" << endl;
+}
+
+/*
+ *  solveClasses()
+ *
+ *  Parameters: distinct matchup classes, probabilities to fill, first class
+ *              to solve, stride between classes
+ *  Does:       Solves every step-th class starting at first.
+ *  Returns:    NA
+ */
+void solveClasses(const vector<MatchupClass> &classes, vector<double> &probs,
+                  unsigned first, unsigned step)
+{
+    for (unsigned long i = first; i < classes.size(); i += step)
+        probs[i] = winProbability(classes[i]);
+}
+
+/*
+ *  writeGrid()
+ *
+ *  Parameters: output stream, filled grid
+ *  Does:       Writes the grid as CSV: a header row of B's levels, then one
+ *              row per level of A starting with that level.
+ *  Returns:    NA
+ */
+void writeGrid(ostream &out, const vector<double> &grid)
+{
+    out << "levelA\\levelB";
+    for (int levelB = 1; levelB <= MAX_LEVEL; levelB++)
+        out << "," << levelB;
+    out << endl;
+
+    for (int levelA = 1; levelA <= MAX_LEVEL; levelA++) {
+        out << levelA;
+        for (int levelB = 1; levelB <= MAX_LEVEL; levelB++)
+            out << "," << grid[(levelA - 1) * MAX_LEVEL + (levelB - 1)];
+        out << endl;
+    }
+}
@@ -0,0 +1,547 @@
+/*
+ *      tune.cpp
+ *
+ *      Purpose: Suggests route level ranges and spawn lists that bring the
+ *               catch rates of a reference roster as close as possible to
+ *               their targets. For each route, searches the low and high
+ *               ends of the route's level range and runs a stochastic
+ *               search over how many of the 20 spawn slots each species
+ *               gets, using the exact catch battle win probability as its
+ *               objective. Routes are tuned in
+ *               parallel and the suggestions are written as route files.
+ *
+ *      Last modified: October 19, 2026
+ */
+
+#include <iostream>
+#include <fstream>
+#include <cmath>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "pokesim.h"
+
+using namespace std;
+
+const int MAX_LEVEL = 100;
+const int SEARCH_STEPS = 4000;
+const int TUNING_ROUNDS = 3;
+
+/*
+ * RosterEntry
+ *
+ * A reference trainer Pokémon: the route it is meant for, its Pokédex
+ * index and level, and the catch rate it should have on that route.
+ */
+struct RosterEntry {
+    string route;
+    int index;
+    int level;
+    double target;
+};
+
+/*
+ * RouteTuning
+ *
+ * One route being tuned: its file and name, its own simulation context,
+ * the distinct spawns on it (species with their stat line and type, since
+ * one species can be listed with different stats), the roster entries
+ * aimed at it, each roster
+ * entry's win probability against each species at every level, and the
+ * current and original level range and slot counts per species.
+ */
+struct RouteTuning {
+    string file;
+    string name;
+    SimContext ctx;
+    vector<Pokemon> species;
+    vector<RosterEntry> roster;
+    vector< vector< vector<double> > > rates;
+    Range range;
+    vector<int> counts;
+    Range oldRange;
+    vector<int> oldCounts;
+};
+
+bool populateRoster(string file, const SimContext &ctx,
+                    vector<RosterEntry> &roster);
+bool setupRoute(RouteTuning &route, string file, string dexFile,
+                const vector<RosterEntry> &roster, unsigned seed);
+void computeRates(RouteTuning &route);
+double catchRate(const RouteTuning &route, int entry, Range range,
+                 const vector<int> &counts);
+double tuningError(const RouteTuning &route, Range range,
+                   const vector<int> &counts);
+bool sameSpawn(const Pokemon &a, const Pokemon &b);
+Range lowestRange(const RouteTuning &route, int width, double target);
+void tuneLevels(RouteTuning &route);
+void tuneSpawns(RouteTuning &route);
+void tuneRoute(RouteTuning &route);
+bool writeRoute(const RouteTuning &route, string outDir);
+void reportRoute(const RouteTuning &route);
+
+int main(int argc, char* argv[])
+{
+    if (argc < 5) {
+        cout << "Usage: ./tune [pokedex] [roster] [output dir] [route]..."
+             << endl;
+        return 1;
+    }
+
+    SimContext dex;
+    string error;
+    vector<RosterEntry> roster;
+
+    initContext(dex, 0);
+    if (not populateDex(dex, argv[1], error)) {
+        cerr << argv[1] << ": " << error << "." << endl;
+        return 1;
+    }
+    if (not populateRoster(argv[2], dex, roster))
+        return 1;
+
+    int count = argc - 4;
+    vector<RouteTuning> routes(count);
+
+    for (int i = 0; i < count; i++) {
+        if (not setupRoute(routes[i], argv[i + 4], argv[1], roster, i + 1)) {
+            cerr << argv[i + 4] << ": cannot open route." << endl;
+            return 1;
+        }
+    }
+
+    // Tunes every route on its own thread; each owns its context
+    vector<thread> pool;
+    for (int i = 0; i < count; i++)
+        pool.push_back(thread(tuneRoute, ref(routes[i])));
+    for (int i = 0; i < count; i++)
+        pool[i].join();
+
+    bool written = true;
+    for (int i = 0; i < count; i++) {
+        reportRoute(routes[i]);
+        if (not writeRoute(routes[i], argv[3])) {
+            cerr << argv[3] << ": cannot write " << routes[i].name << endl;
+            written = false;
+        }
+    }
+
+    return written ? 0 : 1;
+}
+
+/*
+ *  populateRoster()
+ *
+ *  Parameters: name of roster file, context with loaded Pokédex, roster to
+ *              fill
+ *  Does:       Reads one reference Pokémon per line: route name (e.g.
+ *              route1), species, level, and target catch rate (0 - 1).
+ *              Lines are parsed in place like populateDex(); lines
+ *              missing a field are skipped.
+ *  Returns:    True if every line names a Pokémon in the Pokédex
+ */
+bool populateRoster(string file, const SimContext &ctx,
+                    vector<RosterEntry> &roster)
+{
+    ifstream input;
+    string info, name;
+    RosterEntry entry;
+
+    input.open(file);
+    if (not input.is_open()) {
+        cerr << file << ": cannot open roster." << endl;
+        return false;
+    }
+
+    while (getline(input, info)) {
+        const char *text = readWord(info.c_str(), entry.route);
+        text = readWord(text, name);
+        const char *level = readInt(text, entry.level);
+        const char *target = readDouble(level, entry.target);
+
+        if (name.empty() or level == text or target == level)
+            continue;
+
+        entry.index = searchDex(ctx, name);
+        if (entry.index == -1) {
+            cerr << name << ": Pokémon not found." << endl;
+            return false;
+        }
+
+        roster.push_back(entry);
+    }
+
+    return true;
+}
+
+/*
+ *  setupRoute()
+ *
+ *  Parameters: route to set up, route file, Pokédex file, full roster,
+ *              seed for the route's random number generator
+ *  Does:       Loads the route into its own context, collects its distinct
+ *              spawns and how many slots each has, and keeps the roster
+ *              entries aimed at it.
+ *  Returns:    True if the route file could be read
+ */
+bool setupRoute(RouteTuning &route, string file, string dexFile,
+                const vector<RosterEntry> &roster, unsigned seed)
+{
+    string error;
+
+    route.file = file;
+    route.name = routeName(file);
+
+    initContext(route.ctx, seed);
+    if (not populateRoute(route.ctx, file) or route.ctx.route.empty()
+        or not populateDex(route.ctx, dexFile, error))
+        return false;
+
+    for (unsigned long i = 0; i < route.ctx.route.size(); i++) {
+        const Pokemon &mon = route.ctx.route[i];
+        unsigned long s = 0;
+
+        while (s < route.species.size()
+               and not sameSpawn(route.species[s], mon))
+            s++;
+
+        if (s == route.species.size()) {
+            route.species.push_back(mon);
+            route.counts.push_back(0);
+        }
+        route.counts[s]++;
+    }
+
+    for (unsigned long i = 0; i < roster.size(); i++) {
+        if (roster[i].route == route.name)
+            route.roster.push_back(roster[i]);
+    }
+
+    route.range = route.ctx.range;
+    route.oldRange = route.range;
+    route.oldCounts = route.counts;
+
+    return true;
+}
+
+/*
+ *  sameSpawn()
+ *
+ *  Parameters: two route Pokémon
+ *  Does:       Compares their names, stats and types.
+ *  Returns:    True if they are the same spawn
+ */
+bool sameSpawn(const Pokemon &a, const Pokemon &b)
+{
+    return a.name == b.name and a.HP == b.HP and a.attack == b.attack
+           and a.defense == b.defense and a.speed == b.speed
+           and a.type == b.type;
+}
+
+/*
+ *  tuneRoute()
+ *
+ *  Parameters: route to tune
+ *  Does:       Tabulates the roster's win probabilities, then alternates
+ *              level bisection and spawn search for TUNING_ROUNDS rounds.
+ *              Routes without roster entries are left as they are.
+ *  Returns:    NA
+ */
+void tuneRoute(RouteTuning &route)
+{
+    if (route.roster.empty())
+        return;
+
+    computeRates(route);
+
+    for (int round = 0; round < TUNING_ROUNDS; round++) {
+        tuneLevels(route);
+        tuneSpawns(route);
+    }
+}
+
+/*
+ *  computeRates()
+ *
+ *  Parameters: route being tuned
+ *  Does:       Computes each roster entry's exact win probability against
+ *              each of the route's species at every level from 1 to 100,
+ *              solving each distinct hits-to-KO matchup only once.
+ *  Returns:    NA
+ */
+void computeRates(RouteTuning &route)
+{
+    unordered_map<long long, double> solved;
+
+    route.rates.assign(route.roster.size(),
+                       vector< vector<double> >(route.species.size(),
+                                                vector<double>(MAX_LEVEL + 1)));
+
+    for (unsigned long r = 0; r < route.roster.size(); r++) {
+        const RosterEntry &entry = route.roster[r];
+        Pokemon trainer = levelStats(route.ctx.pokedex[entry.index],
+                                     entry.level);
+
+        for (unsigned long s = 0; s < route.species.size(); s++) {
+            for (int level = 1; level <= MAX_LEVEL; level++) {
+                MatchupClass matchup = classifyMatchup(trainer,
+                                          levelStats(route.species[s], level),
+                                          route.ctx.typeChart);
+                long long key = classKey(matchup);
+
+                auto found = solved.find(key);
+                if (found == solved.end())
+                    found = solved.insert(make_pair(key,
+                                          winProbability(matchup))).first;
+
+                route.rates[r][s][level] = found->second;
+            }
+        }
+    }
+}
+
+/*
+ *  catchRate()
+ *
+ *  Parameters: route being tuned, roster entry, level range, slot counts
+ *  Does:       Averages the entry's win probability over every spawn slot
+ *              and every level in the range, as spawn() draws them.
+ *  Returns:    The entry's expected catch rate
+ */
+double catchRate(const RouteTuning &route, int entry, Range range,
+                 const vector<int> &counts)
+{
+    double total = 0.0;
+    int slots = 0;
+
+    for (unsigned long s = 0; s < counts.size(); s++) {
+        double sum = 0.0;
+
+        for (int level = range.low; level <= range.high; level++)
+            sum += route.rates[entry][s][level];
+
+        total += counts[s] * sum / (range.high - range.low + 1);
+        slots += counts[s];
+    }
+
+    return total / slots;
+}
+
+/*
+ *  tuningError()
+ *
+ *  Parameters: route being tuned, level range, slot counts
+ *  Does:       Sums the squared differences between each roster entry's
+ *              catch rate and its target.
+ *  Returns:    The route's tuning error
+ */
+double tuningError(const RouteTuning &route, Range range,
+                   const vector<int> &counts)
+{
+    double error = 0.0;
+
+    for (unsigned long r = 0; r < route.roster.size(); r++) {
+        double miss = catchRate(route, r, range, counts)
+                      - route.roster[r].target;
+        error += miss * miss;
+    }
+
+    return error;
+}
+
+/*
+ *  lowestRange()
+ *
+ *  Parameters: route being tuned, width of the level range, mean target
+ *              catch rate
+ *  Does:       Bisects on the low end of a range of the given width for the
+ *              lowest range whose mean catch rate falls to the target
+ *              (catch rates fall as encounters level up).
+ *  Returns:    The range found
+ */
+Range lowestRange(const RouteTuning &route, int width, double target)
+{
+    int lo = 1;
+    int hi = MAX_LEVEL - width;
+
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        Range range = {mid, mid + width};
+        double mean = 0.0;
+
+        for (unsigned long r = 0; r < route.roster.size(); r++)
+            mean += catchRate(route, r, range, route.counts)
+                    / route.roster.size();
+
+        if (mean <= target)
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+
+    Range range = {lo, lo + width};
+    return range;
+}
+
+/*
+ *  tuneLevels()
+ *
+ *  Parameters: route being tuned
+ *  Does:       Searches both ends of the level range: for every width,
+ *              finds the lowest range whose mean catch rate falls to the
+ *              mean target, and keeps whichever of it and the range one
+ *              level below has the smallest error over all widths. The
+ *              current range is kept unless another is strictly better.
+ *  Returns:    NA
+ */
+void tuneLevels(RouteTuning &route)
+{
+    double target = 0.0;
+
+    for (unsigned long r = 0; r < route.roster.size(); r++)
+        target += route.roster[r].target / route.roster.size();
+
+    Range best = route.range;
+    double bestError = tuningError(route, best, route.counts);
+
+    for (int width = 0; width < MAX_LEVEL; width++) {
+        Range range = lowestRange(route, width, target);
+
+        for (int shift = 0; shift <= 1 and range.low - shift >= 1; shift++) {
+            Range shifted = {range.low - shift, range.high - shift};
+            double error = tuningError(route, shifted, route.counts);
+
+            if (error < bestError) {
+                bestError = error;
+                best = shifted;
+            }
+        }
+    }
+
+    route.range = best;
+}
+
+/*
+ *  tuneSpawns()
+ *
+ *  Parameters: route being tuned
+ *  Does:       Searches over spawn lists by repeatedly moving one slot from
+ *              one species to another, keeping at least one slot per
+ *              species. Moves that lower the error are kept; worse moves
+ *              are occasionally kept early on (simulated annealing) to
+ *              escape local minima. Keeps the best list seen.
+ *  Returns:    NA
+ */
+void tuneSpawns(RouteTuning &route)
+{
+    int species = route.counts.size();
+    if (species < 2)
+        return;
+
+    uniform_int_distribution<int> pick(0, species - 1);
+    uniform_real_distribution<double> chance(0.0, 1.0);
+
+    vector<int> counts = route.counts;
+    double error = tuningError(route, route.range, counts);
+    vector<int> best = counts;
+    double bestError = error;
+
+    for (int step = 0; step < SEARCH_STEPS; step++) {
+        int from = pick(route.ctx.rng);
+        int to = pick(route.ctx.rng);
+
+        if (from == to or counts[from] <= 1)
+            continue;
+
+        counts[from]--;
+        counts[to]++;
+
+        double next = tuningError(route, route.range, counts);
+        double heat = 1e-3 * (1.0 - (double)step / SEARCH_STEPS);
+
+        if (next <= error
+            or chance(route.ctx.rng) < exp((error - next) / heat)) {
+            error = next;
+            if (error < bestError) {
+                bestError = error;
+                best = counts;
+            }
+        } else {
+            counts[from]++;
+            counts[to]--;
+        }
+    }
+
+    route.counts = best;
+}
+
+/*
+ *  writeRoute()
+ *
+ *  Parameters: tuned route, output directory
+ *  Does:       Writes the suggested route file, in the same format as the
+ *              originals: level range, then one line per spawn slot.
+ *  Returns:    True if the file was written
+ */
+bool writeRoute(const RouteTuning &route, string outDir)
+{
+    ofstream output(outDir + "/" + route.name + ".txt");
+    if (not output.is_open())
+        return false;
+
+    output << route.range.low << " " << route.range.high << endl;
+
+    for (unsigned long s = 0; s < route.species.size(); s++) {
+        const Pokemon &mon = route.species[s];
+
+        for (int i = 0; i < route.counts[s]; i++) {
+            output << mon.name << "\t" << fromFixed(mon.HP, STAT_SCALE)
+                   << "\t" << fromFixed(mon.attack, STAT_SCALE)
+                   << "\t" << fromFixed(mon.defense, STAT_SCALE)
+                   << "\t" << fromFixed(mon.speed, STAT_SCALE)
+                   << "\t" << mon.type << endl;
+        }
+    }
+
+    return true;
+}
+
+/*
+ *  reportRoute()
+ *
+ *  Parameters: tuned route
+ *  Does:       Prints the old and suggested level ranges and spawn counts,
+ *              and each roster entry's catch rate before and after.
+ *  Returns:    NA
+ */
+void reportRoute(const RouteTuning &route)
+{
+    cout << "\n------ " << route.name << " ------" << endl;
+
+    if (route.roster.empty()) {
+        cout << "No roster entries; left unchanged." << endl;
+        return;
+    }
+
+    cout << "Levels: " << route.oldRange.low << "-" << route.oldRange.high
+         << " -> " << route.range.low << "-" << route.range.high << endl;
+
+    for (unsigned long s = 0; s < route.species.size(); s++) {
+        if (route.counts[s] != route.oldCounts[s])
+            cout << route.species[s].name << ": " << route.oldCounts[s]
+                 << " -> " << route.counts[s] << " slots" << endl;
+    }
+
+    for (unsigned long r = 0; r < route.roster.size(); r++) {
+        const RosterEntry &entry = route.roster[r];
+
+        cout << route.ctx.pokedex[entry.index].name << " LV. " << entry.level
+             << ": target " << round(entry.target * 100) << "%, was "
+             << round(catchRate(route, r, route.oldRange, route.oldCounts)
+                      * 100)
+             << "%, now "
+             << round(catchRate(route, r, route.range, route.counts) * 100)
+             << "%" << endl;
+    }
+}